@@ -0,0 +1,36 @@
+#ifndef ARGUMENTS_HPP_
+#define ARGUMENTS_HPP_
+
+#include "Token.hpp"
+#include <cstddef>
+#include <vector>
+
+// The arguments of a call, a view over a contiguous run of slots.
+//
+// The interpreter evaluates arguments onto its own argument stack and hands
+// the callee a view of them, so passing arguments allocates nothing. The
+// view indexes through the stack instead of holding a pointer to the first
+// slot, so it stays valid when nested calls grow the stack.
+class Arguments {
+public:
+    Arguments(std::vector<Object> &stack_, size_t base_, size_t count_)
+        : stack(&stack_), base(base_), count(count_) {}
+    /// @brief view all of values, for natives calling back into Lox code
+    explicit Arguments(std::vector<Object> &values)
+        : stack(&values), base(0), count(values.size()) {}
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    Object &operator[](size_t i) const { return (*stack)[base + i]; }
+
+    // not stable across calls that push onto the same stack
+    std::vector<Object>::iterator begin() const { return stack->begin() + base; }
+    std::vector<Object>::iterator end() const { return begin() + count; }
+
+private:
+    std::vector<Object> *stack;
+    size_t base;
+    size_t count;
+};
+
+#endif// ARGUMENTS_HPP_
@@ -0,0 +1,31 @@
+#ifndef ARRAY_KERNELS_HPP_
+#define ARRAY_KERNELS_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+// Bulk numeric kernels behind Float64Array and Int64Array.
+//
+// On x86-64 CPUs with AVX2 the kernels process four elements per
+// instruction, elsewhere they fall back to scalar loops. Vector sums and dot
+// products add in a different order than a scalar loop, so float results
+// may differ from it in the last bits.
+namespace ArrayKernels {
+    double sum(const double *a, size_t n);
+    double min(const double *a, size_t n);
+    double max(const double *a, size_t n);
+    double dot(const double *a, const double *b, size_t n);
+    void scale(double *a, size_t n, double factor);
+    void add(double *a, const double *b, size_t n);
+    void fill(double *a, size_t n, double value);
+
+    int64_t sum(const int64_t *a, size_t n);
+    int64_t min(const int64_t *a, size_t n);
+    int64_t max(const int64_t *a, size_t n);
+    int64_t dot(const int64_t *a, const int64_t *b, size_t n);
+    void scale(int64_t *a, size_t n, int64_t factor);
+    void add(int64_t *a, const int64_t *b, size_t n);
+    void fill(int64_t *a, size_t n, int64_t value);
+}
+
+#endif// ARRAY_KERNELS_HPP_
@@ -0,0 +1,166 @@
+#ifndef BUILTIN_ASYNC_HPP
+#define BUILTIN_ASYNC_HPP
+
+#include "LoxCallable.hpp"
+#include "LoxInstance.hpp"
+#include "Token.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <sys/types.h>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class Generator;
+class Task;
+
+// Asynchronous natives:
+//   readFile(path [, fn])         the contents of the file as a string
+//   writeFile(path, text [, fn])  replace the contents of the file with text
+//   sleep(ms [, fn])              wait ms milliseconds
+//   exec(command [, fn])          run command with /bin/sh, what it wrote to
+//                                 its standard output; exiting with a non-zero
+//                                 status is a runtime error
+//   task(fn, args...)             run fn(args...) as a coroutine, returns a Task
+//   task(generator)               run the generator's body as one
+//   t.wait()                      wait for the task, what fn returned
+//   t.done()                      true once it has finished
+//
+// Given fn, an operation starts in the background and the native returns
+// nil; fn is called with the result (readFile, exec) or with nothing
+// (writeFile, sleep) once it completes. Without fn the native waits for the
+// result. Inside a task only the task waits: it is suspended and the event
+// loop resumes other tasks and calls callbacks until the result is in.
+// Anywhere else the loop runs until the result is in, so tasks and callbacks
+// also progress while top-level code waits. A task that yields gives the
+// others a turn. When the program's statements have run, the loop runs until
+// nothing is pending.
+//
+// A failed operation raises its runtime error where it is waited for, or
+// where its callback would have been called.
+
+// The interpreter's event loop, one per interpreter and only ever run on
+// its thread.
+//
+// Subprocess pipes are watched with epoll and timers wait in a heap ordered
+// by deadline, the nearest one is the epoll timeout. epoll cannot wait on
+// regular files, so reads and writes of files run on a few helper threads
+// that report back through an eventfd in the same epoll set. The helpers
+// only move bytes, tasks are resumed and callbacks are called on the
+// interpreter's thread.
+class EventLoop {
+public:
+    // one asynchronous operation, the loop owns it until it completes
+    struct Operation {
+        enum class Kind { Timer, Read, Write, Process, Task };
+
+        explicit Operation(Kind kind_, std::string target_ = "") : kind(kind_), target(std::move(target_)) {}
+
+        /// @brief what the operation produced, what callbacks are called with
+        Object result() const;
+
+        Kind kind;
+        std::string target;// the path, or the command
+        std::string data;  // the bytes read or written
+        std::string error; // set when it failed
+        Token site;        // the call that started it, where its error is reported
+        bool completed = false;
+        shared_ptr<LoxCallable> callback;
+        std::vector<shared_ptr<Task>> waiting;// tasks suspended on it
+    };
+
+    explicit EventLoop(Interpreter &interpreter);
+    /// @brief stops the helper threads and kills subprocesses still running
+    ~EventLoop();
+
+    /// @brief the interpreter's loop, created on first use
+    static EventLoop &of(Interpreter &interpreter);
+
+    void sleep(const shared_ptr<Operation> &operation, std::chrono::milliseconds delay);
+    void readFile(const shared_ptr<Operation> &operation);
+    void writeFile(const shared_ptr<Operation> &operation);
+    void exec(const shared_ptr<Operation> &operation);
+    /// @brief run the task's body from the next turn on
+    void schedule(shared_ptr<Task> task);
+
+    /// @brief wait until operation completed, suspending the running task
+    /// when called from one
+    void await(const shared_ptr<Operation> &operation);
+    /// @brief run until nothing is pending
+    void run();
+
+private:
+    struct Timer {
+        std::chrono::steady_clock::time_point deadline;
+        uint64_t sequence;// equal deadlines fire in the order they were set
+        shared_ptr<Operation> operation;
+
+        bool operator>(const Timer &other) const {
+            return deadline != other.deadline ? deadline > other.deadline : sequence > other.sequence;
+        }
+    };
+
+    struct Process {
+        pid_t pid;
+        shared_ptr<Operation> operation;
+    };
+
+    Interpreter &interpreter;
+    int epollFd;
+    int eventFd;// written by helpers when a file operation is done
+
+    std::deque<shared_ptr<Task>> ready;
+    std::deque<shared_ptr<Operation>> completed;// waiters not yet told
+    shared_ptr<Task> current;                   // the task being resumed
+    size_t pending = 0;                         // started, not yet completed
+
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers;
+    uint64_t timerSequence = 0;
+    std::unordered_map<int, Process> processes;// by the read end of the pipe
+
+    static constexpr size_t maxHelpers = 4;
+    std::vector<std::thread> helpers;
+    std::mutex lock;// guards what follows
+    std::condition_variable work;
+    std::deque<shared_ptr<Operation>> jobs;
+    std::deque<shared_ptr<Operation>> done;
+    size_t idleHelpers = 0;
+    bool stopping = false;
+
+    bool runOnce();
+    void poll(int timeout);
+    int timeout() const;
+    void complete(shared_ptr<Operation> operation);
+    void notify(const shared_ptr<Operation> &operation);
+    void resume(const shared_ptr<Task> &task);
+    void offload(const shared_ptr<Operation> &operation);
+    void helperMain();
+    void readPipe(int fd);
+};
+
+// A coroutine run by the event loop.
+class Task : public LoxInstance {
+public:
+    explicit Task(shared_ptr<Generator> body);
+
+    shared_ptr<Generator> body;
+    // completes when the body has finished, what wait() waits for
+    shared_ptr<EventLoop::Operation> finished;
+    bool waiting = false;// suspended on an operation
+};
+
+// native functions, registered in NativeFunction.cpp
+Object nativeReadFile(Interpreter &interpreter, Arguments args);
+Object nativeWriteFile(Interpreter &interpreter, Arguments args);
+Object nativeSleep(Interpreter &interpreter, Arguments args);
+Object nativeExec(Interpreter &interpreter, Arguments args);
+Object nativeTask(Interpreter &interpreter, Arguments args);
+
+#endif // BUILTIN_ASYNC_HPP
@@ -3,6 +3,7 @@
 #include "LoxClass.hpp"
 #include "LoxInstance.hpp"
 #include "LoxList.hpp"
+#include "LoxMap.hpp"
 #include <memory>
 #include <string>
 #include <vector>
@@ -12,31 +13,57 @@ public:
 
     explicit ListClass(map<string, shared_ptr<LoxFunction>> methods_);
 
-    Object call(shared_ptr<Interpreter> interpreter, vector<Object> args);
+    Object call(Interpreter &interpreter, Arguments args);
+    size_t arity();
+};
+
+class ListInstance : public LoxInstance {
+public:
+    ListInstance(shared_ptr<LoxClass> klass_, shared_ptr<LoxList> values);
 
-    std::vector<Object> getList() const { return list; }
+    Object getIndex(const Object &key) override;
+    void setIndex(const Object &key, Object value) override;
 
-private:
-    std::vector<Object> list{};
+    /// @brief the LoxList behind the instance
+    LoxList &list();
 };
 
-class ListInstance : public LoxInstance {
+// StringBuilder() collects appended pieces in one growing buffer, so
+// assembling a string from N pieces takes linear time instead of the
+// quadratic time of repeated `+`.
+class StringBuilderClass : public LoxClass {
+public:
+    StringBuilderClass();
+
+    Object call(Interpreter &interpreter, Arguments args);
+    size_t arity();
+};
+
+class StringBuilderInstance : public LoxInstance {
 public:
-    explicit ListInstance(ListClass klass_);
-    // Object get(Token name);
+    explicit StringBuilderInstance(shared_ptr<LoxClass> klass_);
+
+    std::string buffer;
 };
 
-class ListLenMethods : public LoxFunction {
+// map() is a hash map keyed by strings, numbers and booleans, with
+// get/set/has/delete/keys/len and m[key] subscripts. dict is an alias.
+class MapClass : public LoxClass {
 public:
-    explicit ListLenMethods(shared_ptr<Environment> closure_, shared_ptr<Function> declaration_);
-    Object call(shared_ptr<Interpreter> interpreter, vector<Object> args);
-    shared_ptr<ListLenMethods> bind(shared_ptr<ListInstance> instance);
+    MapClass();
+
+    Object call(Interpreter &interpreter, Arguments args);
+    size_t arity();
 };
 
-class ListAppendMethods : public LoxFunction {
+class MapInstance : public LoxInstance {
 public:
-    explicit ListAppendMethods(shared_ptr<Environment> closure_, shared_ptr<Function> declaration_);
-    Object call(shared_ptr<Interpreter> interpreter, vector<Object> args);
-    shared_ptr<ListAppendMethods> bind(shared_ptr<ListInstance> instance);
+    explicit MapInstance(shared_ptr<LoxClass> klass_);
+
+    Object getIndex(const Object &key) override;
+    void setIndex(const Object &key, Object value) override;
+
+    LoxMap map;
 };
+
 #endif// BUILTIN_CLASS_HPP
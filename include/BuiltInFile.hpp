@@ -0,0 +1,69 @@
+#ifndef BUILTIN_FILE_HPP
+#define BUILTIN_FILE_HPP
+
+#include "LoxCallable.hpp"
+#include "LoxInstance.hpp"
+#include "OutputBuffer.hpp"
+#include <memory>
+#include <string>
+
+// File natives:
+//   open(path, mode)  mode "r" returns a FileReader, "w" or "a" a FileWriter
+//   readLines(path)   a FileReader, iterate it with next() until nil
+//   readAll(path)     the whole file as a string, large files are read
+//                     through mmap
+//
+// A FileReader streams the file through one reusable buffer, so files of any
+// size are processed in constant memory. A FileWriter collects writes in an
+// OutputBuffer and writes them in bulk, a write that fails is a runtime error
+// raised by write(), flush() or close().
+
+class FileReader : public LoxInstance {
+public:
+    explicit FileReader(int fd_);
+    ~FileReader();
+
+    /// @brief the next line without its '\n', false at end of file
+    bool readLine(std::string &line);
+    void close();
+
+    static constexpr size_t bufferSize = 64 * 1024;
+
+private:
+    int fd;
+    std::unique_ptr<char[]> buffer;
+    size_t capacity = bufferSize;
+    size_t start = 0;// first unread byte
+    size_t end = 0;  // end of the buffered bytes
+    bool eof = false;
+
+    bool fill();
+};
+
+class FileWriter : public LoxInstance {
+public:
+    explicit FileWriter(int fd_);
+    ~FileWriter();
+
+    void write(std::string_view text);
+    void flush();
+    void close();
+
+private:
+    int fd;
+    OutputBuffer output;
+
+    static void check(int error);
+};
+
+/// @brief the argument as a string, a runtime error naming what it is otherwise
+const std::string &stringArgument(const Object &argument, const char *what);
+/// @brief read fd until end of file, or until size bytes when the size is
+/// known, into content; 0 or the errno of the read that failed
+int readDescriptor(int fd, size_t size, std::string &content);
+
+Object nativeOpen(Interpreter &interpreter, Arguments args);
+Object nativeReadLines(Interpreter &interpreter, Arguments args);
+Object nativeReadAll(Interpreter &interpreter, Arguments args);
+
+#endif // BUILTIN_FILE_HPP
@@ -2,37 +2,12 @@
 #define BUILT_IN_HPP
 
 #include "LoxCallable.hpp"
-#include "LoxFunction.hpp"
 #include <chrono>
-#include <iostream>
 #include <string>
+#include <vector>
 
-class ClockCallable : public LoxCallable {
-public:
-  size_t arity() override;
+// native functions, registered in NativeFunction.cpp
+Object nativeClock(Interpreter &interpreter, Arguments args);
+Object nativeType(Interpreter &interpreter, Arguments args);
 
-  Object call(shared_ptr<Interpreter> interpreter,
-              vector<Object> args) override;
-
-  std::string toString() override;
-
-private:
-  size_t aritys = 0;
-};
-
-class TypeCallable : public LoxCallable {
-public:
-  explicit TypeCallable(size_t arity = 0) : aritys(arity) {}
-
-  size_t arity() override;
-
-  Object call(shared_ptr<Interpreter> interpreter,
-              vector<Object> args) override;
-
-  std::string toString() override;
-
-private:
-  size_t aritys;
-};
-
-#endif // BUILT_IN_HPP
\ No newline at end of file
+#endif // BUILT_IN_HPP
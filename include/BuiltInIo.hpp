@@ -2,38 +2,14 @@
 #define BUILTIN_IO_HPP
 
 #include "LoxCallable.hpp"
-#include "LoxFunction.hpp"
 #include <iostream>
-#include <sstream>
-class PrintCallable : public LoxCallable {
-public:
-  explicit PrintCallable(size_t arity = 0) : aritys{arity} {}
+#include <string>
 
-  size_t arity() override;
+// native functions, registered in NativeFunction.cpp
+Object nativePrint(Interpreter &interpreter, Arguments args);
+Object nativeInput(Interpreter &interpreter, Arguments args);
+Object nativeFlush(Interpreter &interpreter, Arguments args);
 
-  Object call(shared_ptr<Interpreter> interpreter,
-              vector<Object> args) override;
-
-  std::string toString() override;
-
-private:
-  size_t aritys;
-};
-
-class InputCallable : public LoxCallable {
-public:
-  explicit InputCallable(size_t arity = 0) : aritys{arity} {}
-
-  size_t arity() override;
-
-  Object call(shared_ptr<Interpreter> interpreter,
-              vector<Object> args) override;
-
-  std::string toString() override;
-
-private:
-  size_t aritys;
-};
-
-std::string stringify(const Object &item, std::stringstream &stream);
+/// @brief append the printed form of item to out
+void stringify(const Object &item, std::string &out);
 #endif // BUILTIN_IO_HPP
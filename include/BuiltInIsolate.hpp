@@ -0,0 +1,92 @@
+#ifndef BUILTIN_ISOLATE_HPP
+#define BUILTIN_ISOLATE_HPP
+
+#include "BuiltInSerialize.hpp"
+#include "LoxCallable.hpp"
+#include "LoxInstance.hpp"
+#include "RunContext.hpp"
+#include "RuntimeError.hpp"
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+class LoxFunction;
+
+// Isolate natives:
+//   spawn(fn, args...)  run fn(args...) on a new thread, returns an Isolate
+//   isolate.join()      wait for it, the result of fn or its runtime error
+//   channel()           a Channel between isolates
+//   ch.send(value)      queue a copy of value
+//   ch.receive()        wait for the next value, nil once closed and drained
+//   ch.close()          no more sends, wakes every waiting receiver
+//
+// An isolate is an interpreter of its own on the same resolved program. Its
+// globals are the natives and the program's top-level functions and classes,
+// so it shares no Environment with the script that spawned it. fn has to be
+// a top-level function; the arguments, the result and every value sent on a
+// channel are deep copied with the serializer's encoding. Channels are the
+// one thing isolates share, they are passed by reference. Isolates print
+// through the output buffer of the run that spawned them.
+
+class Channel : public LoxInstance {
+public:
+    Channel();
+
+    void send(PackedValue value);
+    /// @brief wait for a value, false when the channel is closed and empty
+    bool receive(PackedValue &value);
+    void close();
+
+    bool sharedAcrossIsolates() const override { return true; }
+
+private:
+    std::mutex lock;
+    std::condition_variable ready;
+    std::deque<PackedValue> queue;
+    bool closed = false;
+};
+
+class Isolate : public LoxInstance {
+public:
+    // what the thread leaves behind, it outlives the Isolate if never joined
+    struct State {
+        State(OutputBuffer &output) : context(output, diagnostics) {}
+
+        std::ostringstream diagnostics;
+        RunContext context;
+        PackedValue result;
+        bool failed = false;
+        std::string error;
+    };
+
+    Isolate(shared_ptr<Interpreter> interpreter, shared_ptr<LoxCallable> function, PackedValue arguments,
+            shared_ptr<State> state);
+    /// @brief joins the thread, an isolate is never left running detached
+    ~Isolate();
+
+    void join();
+    const State &result() const { return *state; }
+
+private:
+    shared_ptr<State> state;
+    std::mutex lock;
+    std::thread thread;
+};
+
+/// @brief value as a top-level function of the program, for the natives
+/// that run it in isolates, throws when it is anything else
+shared_ptr<LoxFunction> topLevelFunction(Interpreter &interpreter, const Object &value, const string &native);
+/// @brief the same top-level function in an isolate of the program
+shared_ptr<LoxCallable> functionIn(Interpreter &isolate, const LoxFunction &function);
+/// @brief the message of an error raised in an isolate, with its line
+string isolateError(const RuntimeError &error);
+
+// native functions, registered in NativeFunction.cpp
+Object nativeSpawn(Interpreter &interpreter, Arguments args);
+Object nativeChannel(Interpreter &interpreter, Arguments args);
+
+#endif // BUILTIN_ISOLATE_HPP
@@ -0,0 +1,31 @@
+#ifndef BUILTIN_JSON_HPP
+#define BUILTIN_JSON_HPP
+
+#include "LoxCallable.hpp"
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// JSON natives:
+//   jsonParse(text)       arrays become [...] lists, objects map() instances,
+//                         integers that fit 32 bits ints, other numbers doubles;
+//                         numbers follow the JSON grammar and one too large
+//                         for a double is an error
+//   jsonStringify(value)  lists, list() and map() instances and instances of
+//                         classes declared in Lox become arrays and objects
+//
+// Parsing runs in two passes like simdjson. The first pass scans the text 64
+// bytes at a time with SSE2 (a scalar loop on other targets) and records the
+// position of every structural character and string quote outside strings;
+// the second pass walks that index to build the values, so it never looks
+// at the inside of strings or at whitespace between tokens.
+
+// native functions, registered in NativeFunction.cpp
+Object nativeJsonParse(Interpreter &interpreter, Arguments args);
+Object nativeJsonStringify(Interpreter &interpreter, Arguments args);
+
+/// @brief the first pass, positions of structural characters and quotes,
+/// false when a string is not terminated
+bool jsonStructuralIndex(std::string_view text, std::vector<uint32_t> &index);
+
+#endif // BUILTIN_JSON_HPP
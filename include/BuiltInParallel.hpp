@@ -0,0 +1,26 @@
+#ifndef BUILTIN_PARALLEL_HPP
+#define BUILTIN_PARALLEL_HPP
+
+#include "LoxCallable.hpp"
+
+// Data-parallel natives:
+//   parallelMap(list, fn)         a new list of fn(element), in order
+//   parallelFor(start, end, fn)   fn(i) for every int i in [start, end)
+//
+// The indices are spread over WorkPool's threads, which steal work from
+// each other. Every participating thread calls fn in an isolate of its own,
+// made like the ones of spawn(), so fn has to be a top-level function and
+// sees the program's functions and classes but not its global variables.
+// Elements and results are copied between the isolates; numbers, strings
+// and other immutable values are passed without copying.
+//
+// Callbacks and tasks that a call of fn starts run to completion in its
+// isolate before the call counts as done.
+//
+// A runtime error in fn stops the loop and is raised by the native.
+
+// native functions, registered in NativeFunction.cpp
+Object nativeParallelMap(Interpreter &interpreter, Arguments args);
+Object nativeParallelFor(Interpreter &interpreter, Arguments args);
+
+#endif // BUILTIN_PARALLEL_HPP
@@ -0,0 +1,45 @@
+#ifndef BUILTIN_SERIALIZE_HPP
+#define BUILTIN_SERIALIZE_HPP
+
+#include "LoxCallable.hpp"
+#include "LoxInstance.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+// Binary serialization natives:
+//   serialize(value)          the encoded value as a string of bytes
+//   serialize(value, writer)  stream the encoding into a FileWriter
+//   deserialize(bytes)        decode a string made by serialize
+//
+// The encoding starts with "LOX" and a version byte, then one tagged value:
+// nil/false/true are a lone tag, ints a zigzag varint, doubles 8 bytes
+// little-endian, strings a varint length and the raw bytes. [...] lists,
+// list() and map() instances and instances of classes declared in Lox are
+// a count followed by their elements, fields or entries. A container met a
+// second time is written as a back reference to the first one, so shared
+// and cyclic graphs survive the round trip. Instances are decoded against
+// the global class of the same name.
+//
+// Functions, classes and instances of other native classes can not be
+// serialized.
+
+// A value on its way from one isolate to another: the same encoding, except
+// that instances shared between isolates (channels) are not copied but kept
+// in a side table and written as their position in it. Numbers, booleans,
+// nil and strings are immutable and move as they are, without encoding.
+struct PackedValue {
+    std::string bytes;// empty when the value is immediate
+    std::vector<shared_ptr<LoxInstance>> shared;
+    Object immediate;
+};
+
+PackedValue packValue(const Object &value);
+/// @brief a deep copy of the packed value, owned by the given interpreter
+Object unpackValue(Interpreter &interpreter, const PackedValue &packed);
+
+// native functions, registered in NativeFunction.cpp
+Object nativeSerialize(Interpreter &interpreter, Arguments args);
+Object nativeDeserialize(Interpreter &interpreter, Arguments args);
+
+#endif // BUILTIN_SERIALIZE_HPP
@@ -19,24 +19,29 @@ public:
     explicit Environment(shared_ptr<Environment> enclosing);
     Environment(shared_ptr<Environment> enclosing, std::map<string, llvm::Value *> llvmRecord) : enclosing(enclosing), llvmRecord_(llvmRecord){};
 
-    void define(string name, Object value);
+    // variables are keyed by their interned name, see Token::name
+    void define(const LoxString *name, Object value);
+    void define(const Token &name, Object value);
+    void define(const string &name, Object value);
     llvm::Value *define(string name, llvm::Value *value);
 
-    void assign(Token name, Object value);
-    void assignAt(int distance, Token name, Object value);
+    void assign(const Token &name, Object value);
+    void assignAt(int distance, const Token &name, Object value);
 
-    Object get(Token name);
-    Object getAt(int distance, string name);
+    Object get(const Token &name);
+    Object getAt(int distance, const LoxString *name);
     llvm::Value *lookup(const string &name);
 
-    unordered_map<string, Object> getValues() const { return values; }
     shared_ptr<Environment> ancestor(int distance);
     shared_ptr<Environment> enclosing;// parent environment link(parent_)
 
 private:
-    unordered_map<string, Object> values;
+    unordered_map<const LoxString *, Object> values;
     std::map<string, llvm::Value *> llvmRecord_;
 
+    // ancestor() without the reference counting, for lookups
+    Environment *ancestorOf(int distance);
+
     std::shared_ptr<Environment> resolve(const string &name) {
         if (llvmRecord_.count(name) != 0) {
             return shared_from_this();
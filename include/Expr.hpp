@@ -59,6 +59,9 @@ class Set;
 template<class R>
 class This;
 
+template<class R>
+class Yield;
+
 template<class R>
 class Super;
 
@@ -78,7 +81,8 @@ enum class ExprType {
     Get,
     Set,
     This,
-    Super
+    Super,
+    Yield
 };
 
 template<class R>
@@ -104,6 +108,7 @@ public:
     virtual R visitSetExpr(shared_ptr<Set<R>> expr) = 0;
     virtual R visitThisExpr(shared_ptr<This<R>> expr) = 0;
     virtual R visitSuperExpr(shared_ptr<Super<R>> expr) = 0;
+    virtual R visitYieldExpr(shared_ptr<Yield<R>> expr) = 0;
 };
 
 template<class R>
@@ -255,9 +260,13 @@ public:
     Token identifier;
     shared_ptr<Expr<R>> index;
     shared_ptr<Expr<R>> value;
+    // a[index:end], either bound may be null when it is left out
+    bool slice;
+    shared_ptr<Expr<R>> end;
 
-    Subscript(Token identifier_, shared_ptr<Expr<R>> index_, shared_ptr<Expr<R>> value_)
-        : identifier(identifier_), index(index_), value(value_) { this->type = ExprType::Subscript; }
+    Subscript(Token identifier_, shared_ptr<Expr<R>> index_, shared_ptr<Expr<R>> value_,
+              bool slice_ = false, shared_ptr<Expr<R>> end_ = nullptr)
+        : identifier(identifier_), index(index_), value(value_), slice(slice_), end(end_) { this->type = ExprType::Subscript; }
     R accept(shared_ptr<Visitor<R>> visitor) override {
         return visitor->visitSubscriptExpr(this->shared_from_this());
     }
@@ -274,6 +283,7 @@ public:
     shared_ptr<Expr<R>> callee;
     Token paren;
     vector<shared_ptr<Expr<R>>> arguments;
+    int nodeId = 0;// stamped by the parser, identifies the node in profiles
 };
 
 template<class R>
@@ -321,6 +331,19 @@ public:
     Token keyword;
     Token method;
 };
+
+// yield value, suspends the generator running it; evaluates to the value
+// the generator is resumed with. value is null for a bare yield.
+template<class R>
+class Yield : public Expr<R>, public std::enable_shared_from_this<Yield<R>> {
+public:
+    Yield(Token keyword_, shared_ptr<Expr<R>> value_) : keyword(keyword_), value(value_) { this->type = ExprType::Yield; }
+    R accept(shared_ptr<Visitor<R>> visitor) override {
+        return visitor->visitYieldExpr(this->shared_from_this());
+    }
+    Token keyword;
+    shared_ptr<Expr<R>> value;
+};
 // TODO
 // template <class R>
 // class Lambda : Expr<R>
@@ -0,0 +1,82 @@
+#ifndef GENERATOR_HPP_
+#define GENERATOR_HPP_
+
+#include "Environment.hpp"
+#include "LoxInstance.hpp"
+#include "Stmt.hpp"
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <ucontext.h>
+#include <vector>
+
+// The result of calling a function whose body contains yield.
+//
+//   gen.next()       run to the next yield and return its value, nil once
+//                    the body has finished
+//   gen.send(value)  the same, and the pending yield evaluates to value
+//   gen.done()       true once the body has finished
+//   gen.close()      finish it early, the body is unwound where it stopped
+//
+// The body runs on a stack of its own, allocated when the generator first
+// runs and switched to with swapcontext, so the tree walker's recursive frames
+// for the body stay alive while it is suspended. Suspending and resuming
+// swap the interpreter's current environment, argument stack and running
+// generator, so generators can be nested and resume each other. A generator
+// that is dropped while suspended is closed, which releases what its frames
+// hold.
+class Generator : public LoxInstance {
+public:
+    Generator(shared_ptr<Function> declaration, shared_ptr<Environment> environment);
+    ~Generator();
+
+    /// @brief run the body until it yields or finishes, the yield it is
+    /// suspended at evaluates to sent
+    Object resume(Interpreter &interpreter, Object sent);
+    /// @brief suspend the running body with value, returns what it is resumed with
+    Object yield(Object value);
+    void close(Interpreter &interpreter);
+
+    bool isDone() const { return finished; }
+    /// @brief true when the running body is close to the end of its stack
+    bool stackExhausted() const;
+    /// @brief what the body returned, nil until it has finished
+    const Object &result() const { return returned; }
+
+    // 8 MiB like a thread's, or LOX_GENERATOR_STACK_KB. The stack is only
+    // reserved, pages are committed once touched and most generators use a
+    // few. Each stack and its guard page are two memory mappings, so
+    // vm.max_map_count (65530 by default) caps live generators at about
+    // 32000 whatever the size. Calls nested deeper than the stack allows
+    // raise a runtime error rather than hitting the guard page.
+    static size_t stackSize();
+    // what is left for unwinding and natives when stackExhausted() is true
+    static constexpr size_t stackReserve = 32 * 1024;
+
+private:
+    struct Closing {};// thrown from yield to unwind a closed generator
+
+    shared_ptr<Function> declaration;
+    shared_ptr<Environment> environment;// the call's, then wherever the body is
+    std::vector<Object> arguments;      // the body's argument stack
+    std::vector<Object> *argumentStack = &arguments;
+    std::weak_ptr<Interpreter> owner;
+    Interpreter *interpreter = nullptr;
+
+    char *stack = nullptr;
+    ucontext_t context;// the body's
+    ucontext_t caller; // whoever resumed it
+    Object transfer;   // the value passed by the last switch
+    Object returned;
+    std::exception_ptr error;
+    bool started = false;
+    bool running = false;
+    bool finished = false;
+    bool closing = false;
+
+    static void entry(unsigned high, unsigned low);
+    void run();
+    void switchIn();
+};
+
+#endif// GENERATOR_HPP_
@@ -41,6 +41,7 @@ public:
     Object visitSetExpr(shared_ptr<Set<Object>> expr);
     Object visitThisExpr(shared_ptr<This<Object>> expr);
     Object visitSuperExpr(shared_ptr<Super<Object>> expr);
+    Object visitYieldExpr(shared_ptr<Yield<Object>> expr);
 
     void visitExpressionStmt(const Expression &stmt);
     void visitPrintStmt(const Print &stmt);
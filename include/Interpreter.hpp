@@ -9,6 +9,8 @@
 
 #include "Environment.hpp"
 #include "Expr.hpp"
+#include "Profile.hpp"
+#include "RunContext.hpp"
 #include "Stmt.hpp"
 #include "Token.hpp"
 
@@ -17,12 +19,17 @@ using std::string;
 using std::unordered_map;
 using std::vector;
 
+class EventLoop;
+class Generator;
+
 class Interpreter : public Visitor<Object>,
                     public Visitor_Stmt,
                     public std::enable_shared_from_this<Interpreter> {
 public:
-    Interpreter();
+    explicit Interpreter(RunContext &context);
     void interpret(vector<shared_ptr<Stmt>> statements);
+    /// @brief a new interpreter for an isolate, see spawn() in BuiltInIsolate.hpp
+    shared_ptr<Interpreter> isolate(RunContext &isolateContext);
     Object visitLiteralExpr(shared_ptr<Literal<Object>> expr);
     Object visitAssignExpr(shared_ptr<Assign<Object>> expr);
     Object visitBinaryExpr(shared_ptr<Binary<Object>> expr);
@@ -41,6 +48,7 @@ public:
     Object visitSetExpr(shared_ptr<Set<Object>> expr);
     Object visitThisExpr(shared_ptr<This<Object>> expr);
     Object visitSuperExpr(shared_ptr<Super<Object>> expr);
+    Object visitYieldExpr(shared_ptr<Yield<Object>> expr);
 
     void visitExpressionStmt(const Expression &stmt);
     void visitPrintStmt(const Print &stmt);
@@ -57,8 +65,22 @@ public:
     void executeBlock(vector<shared_ptr<Stmt>> statements, shared_ptr<Environment> environment);
 
     shared_ptr<Environment> globals = shared_ptr<Environment>(new Environment());
+    shared_ptr<Profile> profile;// records branches, calls and types when set
+    RunContext &context;        // errors and output of the run
+    // the builtin classes, for natives that create lists and maps
+    shared_ptr<LoxClass> listClass;
+    shared_ptr<LoxClass> mapClass;
+    vector<shared_ptr<Stmt>> program;// the top-level statements being interpreted
+    shared_ptr<EventLoop> events;    // created by the first asynchronous native
+    // the paren of the call being made, natives that report errors later
+    // copy it when they are called
+    const Token *callSite = nullptr;
+
+    /// @brief the generator whose body is running, nullptr outside of one
+    Generator *runningGenerator() const { return generator; }
 
     void resolve(shared_ptr<Expr<Object>> expr, int depth);
+    bool isEqual(const Object &a, const Object &b);
 
     /// @brief initialize with current interpreter and environment, // ? to store
     /// env
@@ -73,19 +95,45 @@ public:
         std::shared_ptr<Environment> previous_env;
     };
 
+    /// @brief the argument slots of one call, popped off the argument stack
+    /// when the call returns or throws
+    class ArgumentFrame {
+    public:
+        explicit ArgumentFrame(vector<Object> &stack);
+
+        ~ArgumentFrame();
+
+        const size_t base;
+
+    private:
+        vector<Object> &stack;
+    };
+
 private:
+    friend class Generator;// swaps the running state when it suspends and resumes
+
     // ! some fatal error
     shared_ptr<Environment> &environment = globals;
     // Environment *const global_environment;
     unordered_map<shared_ptr<Expr<Object>>, int> locals;
+    // arguments of the calls in progress, callees get a view of their slots;
+    // a running generator's body uses the generator's own stack
+    vector<Object> mainArguments;
+    vector<Object> *argumentStack = &mainArguments;
+    Generator *generator = nullptr;// the generator whose body is running
+    // what list() methods called on a list literal see as self, see listView
+    shared_ptr<ListInstance> cachedListView;
     Object evaluate(shared_ptr<Expr<Object>> expr);
     void execute(shared_ptr<Stmt> stmt);
     bool isTruthy(Object object);
-    bool isEqual(Object a, Object b);
     void checkNumberOperand(Token operation, Object operand);
     void checkNumberOperands(Token operation, Object left, Object right);
     string stringify(Object object);
     Object lookUpVariable(Token name, shared_ptr<Expr<Object>> expr);
+    Object propertyOf(const Object &object, const Token &name);
+    shared_ptr<ListInstance> listView(const shared_ptr<LoxList> &list);
+    Object evaluateSlice(const Object &target, shared_ptr<Subscript<Object>> expr);
+    size_t sliceBound(shared_ptr<Expr<Object>> bound, size_t missing, size_t length, const Token &name);
 };
 
 #endif// INTERPRETER_HPP_
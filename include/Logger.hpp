@@ -30,17 +30,25 @@ namespace Error {
         }
     };
 
-    void report() noexcept;
+    // The errors of one run. Every stage of the pipeline reports into the
+    // context it was given, so runs on different threads do not mix errors.
+    class ErrorContext {
+    public:
+        void report(std::ostream &out = std::cerr) const noexcept;
+
+        void addRuntimeError(const RuntimeError &error) noexcept;
 
-    void addRuntimeError(const RuntimeError &error) noexcept;
+        void addError(unsigned int line, std::string where, std::string message) noexcept;
 
-    void addError(unsigned int line, std::string where, std::string message) noexcept;
+        void addError(const Token &token, std::string message) noexcept;
 
-    void addError(const Token &token, std::string message) noexcept;
+        /// @brief forget the errors, the REPL goes on after a bad line
+        void clear() noexcept;
 
-    extern bool hadError;
-    extern bool hadRuntimeError;
-    extern std::vector<ErrorInfo> exceptionList;
+        bool hadError = false;
+        bool hadRuntimeError = false;
+        std::vector<ErrorInfo> exceptionList;
+    };
 }// namespace Error
 
-#endif// LOGGER_HPP
\ No newline at end of file
+#endif// LOGGER_HPP
\ No newline at end of file
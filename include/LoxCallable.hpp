@@ -1,6 +1,7 @@
 #ifndef LOXCALLABLE_HPP_
 #define LOXCALLABLE_HPP_
 
+#include "Arguments.hpp"
 #include "Interpreter.hpp"
 #include "Token.hpp"
 #include <memory>
@@ -13,9 +14,10 @@ using std::vector;
 class LoxCallable {
 public:
   virtual ~LoxCallable() = default; // for derived class
+  // arity of callables that take any number of arguments
+  static constexpr size_t VARIADIC = static_cast<size_t>(-1);
   virtual size_t arity() = 0;
-  virtual Object call(shared_ptr<Interpreter> interpreter,
-                      vector<Object> arguments) = 0;
+  virtual Object call(Interpreter &interpreter, Arguments arguments) = 0;
   virtual string toString() = 0;
 };
 
@@ -15,16 +15,20 @@ using std::shared_ptr;
 using std::string;
 using std::vector;
 
-class LoxClass : public LoxCallable {
+class NativeMethod;
+
+class LoxClass : public LoxCallable, public std::enable_shared_from_this<LoxClass> {
 public:
     string name;
     shared_ptr<LoxClass> superclass;
     map<string, shared_ptr<LoxFunction>> methods;
+    map<string, shared_ptr<NativeMethod>> nativeMethods;// methods of builtin classes
 
     shared_ptr<LoxFunction> findMethod(string name);
+    shared_ptr<NativeMethod> findNativeMethod(const string &name);
     explicit LoxClass(string name_, shared_ptr<LoxClass> superclass_, map<string, shared_ptr<LoxFunction>> methods_);
 
-    Object call(shared_ptr<Interpreter> interpreter, vector<Object> arguments);
+    Object call(Interpreter &interpreter, Arguments arguments);
     size_t arity();
     string toString();
 };
@@ -23,10 +23,16 @@ public:
 
   size_t arity();
 
-  Object call(shared_ptr<Interpreter> interpreter, vector<Object> arguments);
+  Object call(Interpreter &interpreter, Arguments arguments);
+  /// @brief a generator that runs the body with arguments when resumed,
+  /// whether or not the body yields
+  shared_ptr<Generator> coroutine(Arguments arguments);
 
   string toString();
   shared_ptr<LoxFunction> bind(shared_ptr<LoxInstance> instance);
+
+private:
+  shared_ptr<Environment> environmentFor(Arguments &arguments);
 };
 
 #endif // LOXFUNCTION_HPP_
@@ -13,13 +13,20 @@ using std::string;
 class LoxInstance : public std::enable_shared_from_this<LoxInstance>
 {
 public:
-    LoxClass klass;
+    shared_ptr<LoxClass> klass;// shared by all instances of the class
     map<string, Object> fields;
 
     Object get(Token name);
     void set(Token name, Object value);
-    explicit LoxInstance(LoxClass klass_);
+    explicit LoxInstance(shared_ptr<LoxClass> klass_);
+    virtual ~LoxInstance() = default;
     string toString();
+
+    // instance[key], native classes that support subscripts override these
+    virtual Object getIndex(const Object &key);
+    virtual void setIndex(const Object &key, Object value);
+    // isolates pass these by reference, everything else is copied
+    virtual bool sharedAcrossIsolates() const { return false; }
 };
 
 #endif // LOXINSTANCE_HPP_
@@ -0,0 +1,47 @@
+#ifndef LOX_JIT_HPP_
+#define LOX_JIT_HPP_
+
+#include <llvm/ExecutionEngine/JITEventListener.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/raw_ostream.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// Runs a compiled module in process with ORC.
+//
+// LOX_PERF reports the JIT-emitted functions to perf: "map" writes
+// /tmp/perf-<pid>.map, "jitdump" uses LLVM's perf listener (for
+// `perf inject --jit`), any other value enables both. Symbols are named
+// after the Lox source, e.g. "Point_norm (shapes.lox:12)".
+class LoxJIT {
+public:
+    explicit LoxJIT(std::string script);
+
+    int run(std::unique_ptr<llvm::Module> module, std::unique_ptr<llvm::LLVMContext> ctx);
+
+    static constexpr const char *lineAttribute = "lox.line";
+
+private:
+    std::string script;
+
+    std::map<std::string, std::string> sourceNames(const llvm::Module &module) const;
+};
+
+// writes the perf map, one "start size name" line per emitted function
+class PerfMapListener : public llvm::JITEventListener {
+public:
+    explicit PerfMapListener(std::map<std::string, std::string> names);
+
+    void notifyObjectLoaded(ObjectKey key, const llvm::object::ObjectFile &obj,
+                            const llvm::RuntimeDyld::LoadedObjectInfo &info) override;
+
+private:
+    std::map<std::string, std::string> names;
+    std::unique_ptr<llvm::raw_fd_ostream> out;
+    std::mutex mutex;
+};
+
+#endif// LOX_JIT_HPP_
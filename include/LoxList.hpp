@@ -1,11 +1,16 @@
 #ifndef LIST_TYPE_HPP
 #define LIST_TYPE_HPP
 #include <algorithm>
+#include <memory>
 #include <stdexcept>
 #include <vector>
 #include "LoxInstance.hpp"
 class Object;
 
+// A list is a window [offset, offset + len) over a shared element buffer.
+// Slicing makes a new window over the same buffer in O(1); the buffer is
+// copied only when a list that shares it is written to (copy-on-write), so
+// writes through a slice never show up in the list it was taken from.
 class LoxList
 {
 public:
@@ -15,6 +20,10 @@ public:
 
     size_t length() const noexcept;
 
+    /// @brief read an element, negative indices count from the end
+    const Object &get(int index) const;
+
+    /// @brief an element for writing, takes a private copy of a shared buffer
     Object &at(int index);
 
     void append(const Object &value);
@@ -23,8 +32,30 @@ public:
 
     void remove(int index);
 
+    /// @brief move the elements out, leaving the list empty
+    std::vector<Object> take();
+
+    /// @brief replace the elements
+    void assign(std::vector<Object> values);
+
+    void reverse();
+
+    void extend(const LoxList &other);
+
+    /// @brief the elements [begin, end) as a list sharing this one's buffer
+    std::shared_ptr<LoxList> slice(size_t begin, size_t end) const;
+
+    const Object *begin() const noexcept { return storage->data() + offset; }
+    const Object *end() const noexcept { return begin() + len; }
+
 private:
-    std::vector<Object> values;
+    LoxList(std::shared_ptr<std::vector<Object>> storage, size_t offset, size_t len);
+
+    size_t position(int index) const;
+    void detach();
+
+    std::shared_ptr<std::vector<Object>> storage;
+    size_t offset = 0u;
     size_t len = 0u;
 };
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,50 @@
+#ifndef LOX_MAP_HPP_
+#define LOX_MAP_HPP_
+
+#include "Token.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Hash map keyed by strings, numbers and booleans.
+//
+// Entries are stored densely in insertion order, and an open-addressing
+// index of 32-bit entry numbers is probed linearly. Probing touches only the
+// small index array and the hash cached in each entry, and a key is compared
+// only when the hashes match. Removal swaps the last entry into the hole and
+// backward-shifts the index, so there are no tombstones.
+//
+// Int and float keys with the same value are the same key.
+class LoxMap {
+public:
+    struct Entry {
+        size_t hash;
+        Object key;
+        Object value;
+    };
+
+    LoxMap();
+
+    size_t size() const noexcept { return entries_.size(); }
+    const std::vector<Entry> &entries() const noexcept { return entries_; }
+
+    /// @brief the value stored under key, nullptr if there is none
+    Object *find(const Object &key);
+    void set(const Object &key, Object value);
+    bool remove(const Object &key);
+
+private:
+    static constexpr int32_t empty = -1;
+
+    std::vector<int32_t> index;
+    std::vector<Entry> entries_;
+
+    static size_t hashKey(const Object &key);
+    static bool sameKey(const Object &a, const Object &b);
+    size_t mask() const { return index.size() - 1; }
+    // the index slot holding key, or the empty slot where it would go
+    size_t probe(const Object &key, size_t hash) const;
+    void grow();
+};
+
+#endif// LOX_MAP_HPP_
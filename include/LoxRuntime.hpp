@@ -0,0 +1,40 @@
+#ifndef LOX_RUNTIME_HPP_
+#define LOX_RUNTIME_HPP_
+
+// Runtime support for code generated by LoxVM.
+//
+// The runtime is compiled twice: into the host executable, and by clang into
+// LLVM bitcode that LoxVM links into every module before optimization, so
+// the small helpers below can be inlined into compiled Lox code.
+// Keep it free of C++ library dependencies and exceptions.
+
+#include <cstdint>
+
+extern "C" {
+
+// growable list of unboxed elements, the element type is known to the caller
+struct LoxRtList {
+    int64_t length;
+    int64_t capacity;
+    char *data;
+};
+
+void *lox_alloc(int64_t size);
+[[noreturn]] void lox_panic(const char *message);
+
+char *lox_str_concat(const char *left, const char *right);
+int32_t lox_str_len(const char *str);
+
+LoxRtList *lox_list_new(int64_t elemSize, int64_t capacity);
+int64_t lox_list_len(const LoxRtList *list);
+void lox_list_append_i32(LoxRtList *list, int32_t value);
+void lox_list_append_f64(LoxRtList *list, double value);
+
+void lox_print_i32(int32_t value);
+void lox_print_f64(double value);
+void lox_print_bool(int32_t value);
+void lox_print_str(const char *value);
+void lox_print_newline();
+}
+
+#endif// LOX_RUNTIME_HPP_
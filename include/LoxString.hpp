@@ -0,0 +1,48 @@
+#ifndef LOX_STRING_HPP_
+#define LOX_STRING_HPP_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+using std::shared_ptr;
+
+// Immutable string value.
+//
+// Objects hold strings by shared pointer, so reading a variable or passing
+// an argument copies a pointer, never the characters. The length and hash
+// are computed once.
+//
+// String literals and identifiers are interned by the scanner: there is one
+// LoxString per distinct interned text, it lives as long as the process,
+// and two interned strings are equal exactly when they are the same object.
+class LoxString {
+public:
+    explicit LoxString(std::string chars_, bool interned_ = false);
+
+    /// @brief the unique interned string with this text, thread safe
+    static shared_ptr<LoxString> intern(std::string_view chars);
+
+    const std::string &str() const { return chars; }
+    size_t length() const { return chars.size(); }
+    size_t hash() const { return hashValue; }
+    bool isInterned() const { return interned; }
+
+    bool equals(const LoxString &other) const {
+        if (this == &other) {
+            return true;
+        }
+        if (interned && other.interned) {
+            return false;
+        }
+        return hashValue == other.hashValue && chars == other.chars;
+    }
+
+private:
+    const std::string chars;
+    const size_t hashValue;
+    const bool interned;
+};
+
+#endif// LOX_STRING_HPP_
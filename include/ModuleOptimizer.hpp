@@ -0,0 +1,67 @@
+#ifndef MODULE_OPTIMIZER_HPP_
+#define MODULE_OPTIMIZER_HPP_
+
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Splits a compiled module into partitions, optimizes the partitions
+// concurrently (each one in a private LLVMContext) and links them back
+// together in partition order.
+//
+// The number of partitions only depends on the module itself, never on the
+// number of worker threads, so the linked output is identical for any -j.
+//
+// With a cache directory every function becomes its own partition, keyed by
+// the hash of its unoptimized bitcode and the optimizer options. Unchanged
+// functions are then read back from the cache instead of being optimized.
+// Functions are no longer inlined into each other that way and their IR is
+// still generated every build, so for small functions a warm cache is no
+// faster than no cache (README.md has numbers). It is only used when
+// LOX_CACHE_DIR asks for it.
+//
+// With a runtime library every partition imports the runtime functions it
+// calls as available_externally copies, so they can be inlined, while the
+// real definitions are emitted once by an extra runtime partition.
+class ModuleOptimizer {
+public:
+    explicit ModuleOptimizer(unsigned jobs = 0, std::string cacheDir = "");
+
+    bool loadRuntime(const std::string &path);
+
+    std::unique_ptr<llvm::Module> run(std::unique_ptr<llvm::Module> module, llvm::LLVMContext &ctx);
+
+    static constexpr unsigned functionsPerPartition = 32;
+    static constexpr unsigned maxPartitions = 64;
+    static constexpr const char *targetCpu = "x86-64";
+    static constexpr const char *cacheVersion = "lox-cache-2";
+
+private:
+    using Bitcode = llvm::SmallVector<char, 0>;
+
+    unsigned jobs;
+    std::string cacheDir;
+    Bitcode runtime;
+    std::string runtimeDigest;
+
+    unsigned partitionCount(const llvm::Module &module) const;
+    std::vector<Bitcode> split(llvm::Module &module, unsigned partitions);
+    std::vector<Bitcode> splitPerFunction(llvm::Module &module);
+    std::unique_ptr<llvm::Module> link(std::vector<Bitcode> &parts, const llvm::Module &original, llvm::LLVMContext &ctx);
+
+    std::string cacheKey(const Bitcode &input) const;
+    bool readCache(const std::string &key, Bitcode &output) const;
+    void writeCache(const std::string &key, const Bitcode &output) const;
+
+    static std::unique_ptr<llvm::Module> extractFunction(const llvm::Function &fn);
+    static void externalizeLocals(llvm::Module &module);
+    static Bitcode writeBitcode(const llvm::Module &module);
+    Bitcode optimizePartition(const Bitcode &input, bool importRuntime) const;
+    void linkRuntime(llvm::Module &module) const;
+    static void optimize(llvm::Module &module);
+};
+
+#endif// MODULE_OPTIMIZER_HPP_
@@ -0,0 +1,64 @@
+#ifndef NATIVE_FUNCTION_HPP_
+#define NATIVE_FUNCTION_HPP_
+
+#include "Environment.hpp"
+#include "LoxCallable.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+class LoxInstance;
+
+// A builtin implemented in C++. Every native declares its name and arity
+// (or VARIADIC) once in the registry, and calling it is a single call
+// through a function pointer, no RTTI and no allocation per call.
+class NativeFunction : public LoxCallable {
+public:
+    using Fn = Object (*)(Interpreter &interpreter, Arguments arguments);
+
+    NativeFunction(string name_, size_t arity_, Fn fn_);
+
+    size_t arity() override;
+    Object call(Interpreter &interpreter, Arguments arguments) override;
+    string toString() override;
+
+private:
+    string name;
+    size_t aritys;
+    Fn fn;
+};
+
+// A builtin method of a native class such as list. The class keeps an
+// unbound prototype, property access binds it to the receiver the same way
+// LoxFunction::bind binds `this`.
+class NativeMethod : public LoxCallable {
+public:
+    using Fn = Object (*)(Interpreter &interpreter, LoxInstance &self, Arguments arguments);
+
+    NativeMethod(string name_, size_t arity_, Fn fn_, shared_ptr<LoxInstance> self_ = nullptr);
+
+    shared_ptr<NativeMethod> bind(shared_ptr<LoxInstance> instance);
+    /// @brief call the method on self without binding it first
+    Object callOn(Interpreter &interpreter, LoxInstance &self, Arguments arguments) const {
+        return fn(interpreter, self, arguments);
+    }
+
+    size_t arity() override;
+    Object call(Interpreter &interpreter, Arguments arguments) override;
+    string toString() override;
+
+private:
+    string name;
+    size_t aritys;
+    Fn fn;
+    shared_ptr<LoxInstance> self;
+};
+
+/// @brief define every registered native function in globals
+void defineNatives(Environment &globals);
+
+#endif// NATIVE_FUNCTION_HPP_
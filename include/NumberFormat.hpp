@@ -0,0 +1,28 @@
+#ifndef NUMBER_FORMAT_HPP_
+#define NUMBER_FORMAT_HPP_
+
+#include <cstddef>
+#include <string>
+
+// Number to text conversion shared by print and Object::toString.
+//
+// Doubles are written in the shortest form that reads back to the same value
+// (std::to_chars round-trip formatting), so 0.1 prints as 0.1, 1e-8 is not
+// rounded to 0, and integral values print without a fraction. Like
+// JavaScript, magnitudes from 1e-6 up to 1e21 never use an exponent.
+// Both functions write into a caller buffer of at least maxNumberLength
+// bytes, return the length, and never allocate.
+
+constexpr size_t maxNumberLength = 32;
+
+size_t formatNumber(double value, char *buffer);
+size_t formatNumber(int value, char *buffer);
+
+/// @brief append the formatted number to out
+template<typename T>
+void appendNumber(std::string &out, T value) {
+    char buffer[maxNumberLength];
+    out.append(buffer, formatNumber(value, buffer));
+}
+
+#endif// NUMBER_FORMAT_HPP_
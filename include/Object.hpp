@@ -13,8 +13,9 @@ class LoxClass;
 class LoxInstance;
 class ListInstance;
 class LoxList;
+class LoxString;
 //monostate non-valid state in variant in c++17
-using Objects = std::variant<std::string, double, bool, std::monostate, shared_ptr<LoxList>, shared_ptr<LoxCallable>, shared_ptr<LoxInstance>, shared_ptr<LoxClass>, int>;
+using Objects = std::variant<shared_ptr<LoxString>, double, bool, std::monostate, shared_ptr<LoxList>, shared_ptr<LoxCallable>, shared_ptr<LoxInstance>, shared_ptr<LoxClass>, int>;
 class Object {
 public:
     Objects data;
@@ -26,6 +27,10 @@ public:
     static Object make_nil_obj();
     static Object make_class_obj(shared_ptr<LoxClass> lox_class_);
 
+    // a new string value, and an interned one for string constants
+    static Object make_obj(std::string data_);
+    static Object make_obj(const char *data_);
+
     template<typename T>
     static Object make_obj(T data_) {
         Object obj;
@@ -0,0 +1,70 @@
+#ifndef OUTPUT_BUFFER_HPP_
+#define OUTPUT_BUFFER_HPP_
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+// Buffered writer on a file descriptor, used for everything the interpreter
+// prints and by the file writer natives. Output is collected in one reusable
+// buffer and handed to the kernel with bulk write(2) calls, so printing a
+// line costs a memcpy instead of a trip through iostreams.
+//
+// The buffer is flushed when it is full, at exit, before input() reads and by
+// the flush() native. In line-buffered mode every finished line is flushed;
+// that is the default when the descriptor is a TTY, for stdout
+// LOX_LINE_BUFFERED=0 or 1 overrides it.
+//
+// A buffer made on a string captures the output in memory instead, which is
+// how run-batch keeps the output of scripts running side by side apart.
+// Writes are serialized by a lock, isolates print through their parent's
+// buffer and a line written with writeLine() is never split.
+//
+// A write(2) that fails drops the rest of that flush and records its errno,
+// owners that must not lose data check takeError() after flushing.
+class OutputBuffer {
+public:
+    explicit OutputBuffer(int fd, size_t capacity = defaultCapacity);
+    /// @brief flushes append to sink rather than writing to a descriptor
+    explicit OutputBuffer(std::string &sink, size_t capacity = defaultCapacity);
+    ~OutputBuffer();
+
+    OutputBuffer(const OutputBuffer &) = delete;
+    OutputBuffer &operator=(const OutputBuffer &) = delete;
+
+    /// @brief the buffer in front of stdout, flushed when the process exits
+    static OutputBuffer &standard();
+
+    void write(std::string_view text);
+    void put(char c);
+    /// @brief text and a line break in one piece, flushes in line-buffered mode
+    void writeLine(std::string_view text);
+    /// @brief terminate the current line, flushes in line-buffered mode
+    void endLine();
+    void flush();
+    /// @brief errno of the first write that failed since the last call, 0 if none
+    int takeError();
+
+    void setLineBuffered(bool enabled) { lineBuffered = enabled; }
+    bool isLineBuffered() const { return lineBuffered; }
+
+    static constexpr size_t defaultCapacity = 64 * 1024;
+
+private:
+    int fd;
+    std::string *sink = nullptr;
+    size_t capacity;
+    size_t size = 0;
+    bool lineBuffered;
+    int error = 0;
+    std::unique_ptr<char[]> data;
+    std::mutex lock;
+
+    void append(std::string_view text);
+    void flushBuffer();
+    void writeAll(const char *bytes, size_t length);
+};
+
+#endif// OUTPUT_BUFFER_HPP_
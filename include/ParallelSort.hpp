@@ -0,0 +1,72 @@
+#ifndef PARALLEL_SORT_HPP_
+#define PARALLEL_SORT_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Merge sort across the hardware threads for large arrays of plain keys.
+//
+// The array is cut into one run per thread (rounded down to a power of two),
+// the runs are sorted concurrently with std::sort and then merged pairwise,
+// every round merging its pairs concurrently into a scratch buffer. Below
+// parallelSortThreshold elements, or on a single core, it is std::sort.
+//
+// The keys must be safe to touch from other threads: numbers, string_views,
+// never lox Objects, whose reference counts are not atomic-safe to share.
+constexpr size_t parallelSortThreshold = 1 << 16;
+
+template<typename T, typename Less>
+void parallelSort(std::vector<T> &items, Less less) {
+    size_t count = items.size();
+    size_t runs = 1;
+    size_t threads = std::thread::hardware_concurrency();
+    while (runs * 2 <= threads && count / (runs * 2) >= parallelSortThreshold / 2) {
+        runs *= 2;
+    }
+    if (count < parallelSortThreshold || runs == 1) {
+        std::sort(items.begin(), items.end(), less);
+        return;
+    }
+
+    std::vector<size_t> bounds(runs + 1);
+    for (size_t i = 0; i <= runs; i++) {
+        bounds[i] = count * i / runs;
+    }
+    auto inParallel = [](size_t tasks, auto task) {
+        std::vector<std::thread> workers;
+        workers.reserve(tasks - 1);
+        for (size_t i = 1; i < tasks; i++) {
+            workers.emplace_back(task, i);
+        }
+        task(0);
+        for (auto &worker: workers) {
+            worker.join();
+        }
+    };
+
+    inParallel(runs, [&](size_t run) {
+        std::sort(items.begin() + bounds[run], items.begin() + bounds[run + 1], less);
+    });
+
+    std::vector<T> scratch(count);
+    std::vector<T> *from = &items;
+    std::vector<T> *to = &scratch;
+    for (size_t width = 1; width < runs; width *= 2) {
+        inParallel(runs / (width * 2), [&](size_t pair) {
+            size_t first = bounds[pair * width * 2];
+            size_t middle = bounds[pair * width * 2 + width];
+            size_t last = bounds[pair * width * 2 + width * 2];
+            std::merge(from->begin() + first, from->begin() + middle,
+                       from->begin() + middle, from->begin() + last,
+                       to->begin() + first, less);
+        });
+        std::swap(from, to);
+    }
+    if (from != &items) {
+        items.swap(scratch);
+    }
+}
+
+#endif// PARALLEL_SORT_HPP_
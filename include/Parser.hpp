@@ -16,15 +16,23 @@ using std::shared_ptr;
 using std::string;
 using std::vector;
 
+namespace Error {
+    class ErrorContext;
+}
+
 class Parser {
 public:
-    explicit Parser(vector<Token> tokens_) : tokens(tokens_) {}
+    Parser(vector<Token> tokens_, Error::ErrorContext &errors_) : tokens(tokens_), errors(errors_) {}
     vector<shared_ptr<Stmt>> parse();
 
 private:
     vector<Token> tokens;
+    Error::ErrorContext &errors;
     int current = 0;
+    int nextNodeId = 0;// ids of profiled nodes, in parse order
+    bool sawYield = false;// a yield in the body of the function being parsed
     shared_ptr<Expr<Object>> assignment();
+    shared_ptr<Expr<Object>> yieldExpression();
     shared_ptr<Expr<Object>> orExpression();
     shared_ptr<Expr<Object>> andExpression();
     shared_ptr<Expr<Object>> expression();
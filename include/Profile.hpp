@@ -0,0 +1,67 @@
+#ifndef PROFILE_HPP_
+#define PROFILE_HPP_
+
+#include "Arguments.hpp"
+#include "Token.hpp"
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// Execution profile recorded by the interpreter and consumed by LoxVM.
+//
+// Nodes are identified by the id the Parser stamps on If, While, Call and
+// Function nodes in parse order, so a profile only matches the source it
+// was recorded from; the source hash is checked when loading.
+//
+// File format, one record per line:
+//   loxprof <version> <source hash>
+//   branch <node> <taken> <not taken>
+//   call <node> <count> <callee node, 0 for builtins, -1 if polymorphic>
+//   function <node> <count> <return type> <param types...>
+// Types are the names used by type(), "mixed" when more than one was seen.
+class Profile {
+public:
+    struct Branch {
+        uint64_t taken = 0;
+        uint64_t notTaken = 0;
+    };
+    struct CallSite {
+        uint64_t count = 0;
+        int callee = 0;
+    };
+    struct FunctionEntry {
+        uint64_t count = 0;
+        std::string returnType;
+        std::vector<std::string> paramTypes;
+    };
+
+    explicit Profile(const std::string &source);
+
+    // recording, called by the interpreter
+    void branch(int node, bool taken);
+    void call(int node, int callee);
+    void enter(int node, const Arguments &arguments);
+    void leave(int node, const Object &result);
+
+    bool save(const std::string &path) const;
+    bool load(const std::string &path);
+
+    const Branch *findBranch(int node) const;
+    const CallSite *findCall(int node) const;
+    const FunctionEntry *findFunction(int node) const;
+
+    static std::string typeName(const Object &object);
+
+    static constexpr int version = 1;
+
+private:
+    std::string sourceHash;
+    std::map<int, Branch> branches;
+    std::map<int, CallSite> calls;
+    std::map<int, FunctionEntry> functions;
+
+    static void merge(std::string &seen, const std::string &type);
+};
+
+#endif// PROFILE_HPP_
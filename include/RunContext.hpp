@@ -0,0 +1,22 @@
+#ifndef RUN_CONTEXT_HPP_
+#define RUN_CONTEXT_HPP_
+
+#include "Logger.hpp"
+#include "OutputBuffer.hpp"
+#include <iostream>
+
+// The mutable state of one run of a script: the errors its stages report,
+// the buffer its output goes to and the stream the errors are reported on.
+// lox.cpp owns one per run and hands it to the scanner, parser, resolver
+// and interpreter, so separate runs share no state and can execute on
+// separate threads.
+struct RunContext {
+    explicit RunContext(OutputBuffer &output_ = OutputBuffer::standard(), std::ostream &diagnostics_ = std::cerr)
+        : output(output_), diagnostics(diagnostics_) {}
+
+    Error::ErrorContext errors;
+    OutputBuffer &output;
+    std::ostream &diagnostics;
+};
+
+#endif// RUN_CONTEXT_HPP_
@@ -11,9 +11,14 @@ using std::string;
 using std::unordered_map;
 using std::vector;
 
+namespace Error {
+  class ErrorContext;
+}
+
 class Scanner {
 private:
   string source;
+  Error::ErrorContext &errors;
   vector<Token> tokens;
   static const unordered_map<string, TokenType> keywords;
   size_t start = 0;
@@ -37,7 +42,7 @@ private:
   inline bool isAtEnd() const;
 
 public:
-  explicit Scanner(string source);
+  Scanner(string source, Error::ErrorContext &errors);
   vector<Token> scanTokens();
 };
 
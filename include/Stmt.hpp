@@ -120,6 +120,7 @@ public:
     IfBranch main_branch;
     vector<IfBranch> elif_branches;
     shared_ptr<Stmt> else_branch;
+    int nodeId = 0;// stamped by the parser, identifies the node in profiles
 };
 
 class While : public Stmt {
@@ -131,6 +132,7 @@ public:
     }
     shared_ptr<Expr<Object>> condition;
     shared_ptr<Stmt> body;
+    int nodeId = 0;// stamped by the parser, identifies the node in profiles
 };
 
 class Function : public Stmt, public std::enable_shared_from_this<Function> {
@@ -144,6 +146,8 @@ public:
     vector<std::pair<Token, string>> params;
     vector<shared_ptr<Stmt>> body;
     Token returnTypeName;
+    int nodeId = 0;          // stamped by the parser, identifies the node in profiles
+    bool isGenerator = false;// its body yields, calling it makes a Generator
 };
 
 class Print : public Stmt {
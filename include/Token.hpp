@@ -64,6 +64,7 @@ typedef enum {
     LAMBDA,
     TRY,
     THROW,
+    YIELD,
 
     TOKEN_EOF
 } TokenType;
@@ -73,10 +74,15 @@ public:
     Token();
     Token(TokenType type, string lexeme, Object literal, int line);
     string toString();
+    /// @brief the interned lexeme, the key of the variable it names
+    const LoxString *name() const;
     TokenType type;
     string lexeme;
     Object literal;
     int line;
+
+private:
+    mutable const LoxString *interned = nullptr;// set by the scanner for identifiers
 };
 
 #endif// TOKEN_HPP_
@@ -0,0 +1,52 @@
+#ifndef TYPED_ARRAY_HPP_
+#define TYPED_ARRAY_HPP_
+#include "LoxClass.hpp"
+#include "LoxInstance.hpp"
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+
+// Float64Array and Int64Array hold numbers unboxed in one contiguous, 64-byte
+// aligned buffer. Float64Array(n) makes n zeros, Float64Array([1, 2, 3])
+// copies a list literal or list(). sum/min/max/dot/scale/add/fill run the bulk kernels of
+// ArrayKernels instead of boxing every element in an interpreted loop.
+template<typename T>
+class TypedArrayClass : public LoxClass {
+public:
+    explicit TypedArrayClass(const string &name);
+
+    Object call(Interpreter &interpreter, Arguments args);
+    size_t arity();
+};
+
+template<typename T>
+class TypedArray : public LoxInstance {
+public:
+    TypedArray(shared_ptr<LoxClass> klass_, size_t length);
+
+    Object getIndex(const Object &key) override;
+    void setIndex(const Object &key, Object value) override;
+
+    T *data() { return buffer.get(); }
+    size_t length() const { return size; }
+
+    /// @brief convert a lox number to an element, throws for other values
+    static T element(const Object &value);
+    /// @brief box an element as a lox number
+    static Object box(T value);
+
+private:
+    struct Free {
+        void operator()(T *p) const { std::free(p); }
+    };
+
+    std::unique_ptr<T[], Free> buffer;
+    size_t size;
+
+    size_t position(const Object &key) const;
+};
+
+using Float64ArrayClass = TypedArrayClass<double>;
+using Int64ArrayClass = TypedArrayClass<int64_t>;
+
+#endif// TYPED_ARRAY_HPP_
@@ -0,0 +1,50 @@
+#ifndef WORK_POOL_HPP_
+#define WORK_POOL_HPP_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing pool behind the parallel natives, one thread per core
+// besides the caller.
+//
+// parallelFor() splits [0, count) into one range per participant. Each
+// participant eats its own range from the front in chunks of an eighth of
+// what is left, so chunks start large and shrink towards the end. One that
+// runs dry steals the back half of the largest range still open. The caller
+// always participates, so a loop finishes even when every pool thread is busy
+// with another one, and loops can be nested or started from several threads.
+class WorkPool {
+public:
+    // participant is below participants() and the same for every chunk one
+    // thread runs in a loop, callers keep per-participant state with it
+    using Body = std::function<void(size_t participant, size_t begin, size_t end)>;
+
+    /// @brief the pool of the process, started on first use
+    static WorkPool &shared();
+
+    /// @brief the most threads that work on one loop, the caller included
+    size_t participants() const { return threads.size() + 1; }
+
+    /// @brief run body over every index of [0, count) once and wait for it,
+    /// the first exception body throws is rethrown once the loop has stopped
+    void parallelFor(size_t count, const Body &body);
+
+private:
+    struct Loop;
+
+    explicit WorkPool(size_t threadCount);
+    void workerMain();
+
+    std::vector<std::thread> threads;
+    std::mutex lock;
+    std::condition_variable wake;
+    std::deque<std::shared_ptr<Loop>> queue;// one entry per thread invited to a loop
+};
+
+#endif// WORK_POOL_HPP_
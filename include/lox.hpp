@@ -1,8 +1,12 @@
 #ifndef LOX_HPP_
 #define LOX_HPP_
 
+#include "Profile.hpp"
+#include "RunContext.hpp"
 #include "RuntimeError.hpp"
+#include <memory>
 #include <string>
+#include <vector>
 
 using std::string;
 
@@ -12,10 +16,28 @@ public:
 
 private:
     static void runFile(string path);
-    static void buildFile(string path);
+    static void buildFile(string path, unsigned jobs = 0);
+    static void jitFile(string path, unsigned jobs = 0);
+    static void profileFile(string path);
+    static void batchCommand(int argc, const char *argv[]);
+    static void usage();
+    static bool parseJobs(const char *text, unsigned &jobs);
 
-    static void run(string source);
-    static void build(string source);
+    // what one script of run-batch printed, its exit status and run time
+    struct BatchResult {
+        string output;
+        string errors;
+        int status = 0;
+        double milliseconds = 0;
+    };
+    static BatchResult runIsolated(const string &path);
+    static size_t batchFiles(const std::vector<string> &paths, unsigned jobs = 0);
+
+    static void run(RunContext &context, string source, std::shared_ptr<Profile> profile = nullptr);
+    static void build(string source, const string &path, unsigned jobs = 0);
+    static int jit(string source, const string &path, unsigned jobs = 0);
+    static std::shared_ptr<Profile> loadProfile(const string &source, const string &path);
+    static string cacheDirectory();
 
     static void runPrompt();
 };
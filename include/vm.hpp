@@ -1,5 +1,6 @@
 #include "./Environment.hpp"
 #include "./IRgenerator.hpp"
+#include "./Profile.hpp"
 #include <llvm/IR/GlobalVariable.h>
 #include <llvm/IR/IRBuilderFolder.h>
 #include <llvm/IR/Type.h>
@@ -9,14 +10,9 @@
 
 using Env = std::shared_ptr<Environment>;
 
-// Generic binary operator:
-#define GEN_BINARY_OP(Op, varName)                    \
-    do {                                              \
-        auto left = evaluate(expr->left);             \
-        auto right = evaluate(expr->right);           \
-        auto val = builder->Op(left, right, varName); \
-        return Object::make_llvmval_obj(val);         \
-    } while (false)
+// Generic binary operator, on the evaluated left and right operands:
+#define GEN_BINARY_OP(Op, varName) \
+    return Object::make_llvmval_obj(builder->Op(left, right, varName))
 
 // class information
 struct ClassInfo {
@@ -30,9 +26,10 @@ class LoxVM : public Visitor<Object>,
               public Visitor_Stmt,
               public std::enable_shared_from_this<LoxVM> {
 public:
-    LoxVM() {
+    explicit LoxVM(unsigned jobs = 0, std::string cacheDir = "") : jobs(jobs), cacheDir(std::move(cacheDir)) {
         moduleInit();
         setupExternalFunctions();
+        setupListType();
         setupGlobalEnvironment();
         setupTargetTriple();
     };
@@ -50,10 +47,15 @@ public:
     };
 
     void exec(vector<shared_ptr<Stmt>> &statements);
+    int jit(vector<shared_ptr<Stmt>> &statements, const std::string &script);// run with the ORC JIT
+    void setProfile(std::shared_ptr<const Profile> profile);                // use an interpreter profile
+
+    static constexpr uint64_t hotFunctionCalls = 1000;// entry count that earns an inline hint
 
 private:
     void compile(vector<shared_ptr<Stmt>> &statements);
     void saveModuleToFile(const std::string &fileName);
+    bool optimizeModule();                                                                              // optimize partitions in parallel
     void moduleInit();                                                                                  // init module and context
     void setupExternalFunctions();                                                                      // setup external functions
     void setupGlobalEnvironment();                                                                      // setup global environment
@@ -71,6 +73,17 @@ private:
     bool hasReturnType(shared_ptr<Stmt> stmt);                                                      // check if a function has return type
     llvm::FunctionType *excrateFunType(shared_ptr<Function> stmt);                                  // extract function type
     llvm::Value *createInstance(shared_ptr<Call<Object>> expr, Env env, const std::string &varName);// create instance
+    llvm::Value *callRuntime(const std::string &name, std::vector<llvm::Value *> args);              // call a runtime library function
+    std::string listSuffix(llvm::Type *elemType);                                                   // runtime suffix of a list element type
+    void printValue(llvm::Value *value);                                                            // print one value with the runtime
+    llvm::Value *convert(llvm::Value *value, llvm::Type *type);                                     // convert between number types
+    llvm::Type *profiledType(const std::string &typeName);                                          // type observed by the profile
+    llvm::MDNode *branchWeights(int node);                                                          // profiled branch weights
+    void setupListType();                                                                           // list header type and TBAA
+    llvm::Value *listHeader(llvm::Value *handle, unsigned field, llvm::MDNode *tbaa, llvm::Type *type);// load a list header field
+    llvm::Value *listElementPtr(llvm::Value *handle, llvm::Value *index, llvm::Type *elemType);      // bounds checked element address
+    llvm::MDNode *elementTbaa(llvm::Type *elemType);                                                // TBAA tag of list elements
+    Object callListMethod(llvm::Value *list, const Token &name, shared_ptr<Call<Object>> expr);     // xs.len(), xs.append(v)
 
     llvm::StructType *getClassByName(const std::string &name);             // get class by name
     void inheritClass(llvm::StructType *cls, llvm::StructType *parent);    // inherit parent class field
@@ -78,7 +91,9 @@ private:
     void buildClassBody(llvm::StructType *cls);                            // build class body
 
 
-    static llvm::Value *lastValue;                 // last value generated
+    llvm::Value *lastValue = nullptr;              // last value generated
+    unsigned jobs;                                 // optimizer threads, 0 means all cores
+    std::string cacheDir;                          // optimized function cache, empty disables it
     std::vector<llvm::Value *> Values;             // all IR values
     Env globalEnv;                                 // global environment
     Env &environment = globalEnv;                  // current env
@@ -89,6 +104,13 @@ private:
     std::unique_ptr<llvm::IRBuilder<>> builder;    // enter at the end of the function entry block
     llvm::StructType *cls = nullptr;               // current compiling class type
     std::map<std::string, ClassInfo> classMap_;    // class map
+    std::map<llvm::Value *, llvm::Type *> listTypes;// element type of list handles and list variables
+    std::shared_ptr<const Profile> profile;        // interpreter profile, may be null
+    llvm::StructType *listTy = nullptr;            // LoxRtList header {length, capacity, data}
+    llvm::MDNode *tbaaLength = nullptr;            // TBAA tags keep element stores from
+    llvm::MDNode *tbaaData = nullptr;              // clobbering the list header, so length
+    llvm::MDNode *tbaaInt = nullptr;               // and data loads can be hoisted out of loops
+    llvm::MDNode *tbaaDouble = nullptr;
 
     //runner functon
 
@@ -118,6 +140,7 @@ private:
     Object visitSetExpr(shared_ptr<Set<Object>> expr);
     Object visitThisExpr(shared_ptr<This<Object>> expr);
     Object visitSuperExpr(shared_ptr<Super<Object>> expr);
+    Object visitYieldExpr(shared_ptr<Yield<Object>> expr);
 
     void visitExpressionStmt(const Expression &stmt);
     void visitPrintStmt(const Print &stmt);
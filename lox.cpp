@@ -3,17 +3,27 @@
 // #include "./include/IRgenerator.hpp"
 #include "./include/Interpreter.hpp"
 #include "./include/Logger.hpp"
+#include "./include/OutputBuffer.hpp"
 #include "./include/Parser.hpp"
 #include "./include/Resolver.hpp"
+#include "./include/RunContext.hpp"
 #include "./include/RuntimeError.hpp"
 #include "./include/Scanner.hpp"
 #include "./include/vm.hpp"
 #include "include/Token.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 using std::cout;
 using std::endl;
@@ -24,15 +34,30 @@ using std::stringstream;
 using std::vector;
 
 int lox::runScript(int argc, const char *argv[]) {
-    if (argc > 3) {
-        printf("Usage: main run [script] \n");
+    if (argc >= 2 && string(argv[1]) == "run-batch") {
+        batchCommand(argc, argv);
+    } else if (argc > 4 || (argc == 4 && string(argv[1]) != "build" && string(argv[1]) != "jit")) {
+        usage();
+    } else if (argc == 4) {
+        unsigned jobs;
+        if (!parseJobs(argv[3], jobs)) {
+            usage();
+        } else if (string(argv[1]) == "build") {
+            buildFile(argv[2], jobs);
+        } else {
+            jitFile(argv[2], jobs);
+        }
     } else if (argc == 3) {
         if (string(argv[1]) == "run") {
             runFile(argv[2]);
         } else if (string(argv[1]) == "build") {
             buildFile(argv[2]);
+        } else if (string(argv[1]) == "jit") {
+            jitFile(argv[2]);
+        } else if (string(argv[1]) == "profile") {
+            profileFile(argv[2]);
         } else {
-            printf("Use run or build \n");
+            printf("Use run, build, jit or profile \n");
         }
 
     } else {
@@ -41,87 +66,303 @@ int lox::runScript(int argc, const char *argv[]) {
     return 0;
 }
 
-std::string readFile(std::string_view filename) {
+void lox::usage() {
+    printf("Usage: main run [script] \n");
+    printf("       main run-batch [-j jobs] [script | @manifest]... \n");
+    printf("       main build [script] [jobs] \n");
+    printf("       main jit [script] [jobs] \n");
+    printf("       main profile [script] \n");
+}
+
+/// @brief a job count from the command line, false unless it is a positive integer
+bool lox::parseJobs(const char *text, unsigned &jobs) {
+    if (*text < '0' || *text > '9') {
+        return false;
+    }
+    char *end;
+    errno = 0;
+    unsigned long value = std::strtoul(text, &end, 10);
+    if (*end != '\0' || errno == ERANGE || value == 0 || value > 1024) {
+        return false;
+    }
+    jobs = static_cast<unsigned>(value);
+    return true;
+}
+
+bool readSource(std::string_view filename, std::string &buffer) {
     std::ifstream file{filename.data(), std::ios::ate};
     if (!file) {
-        std::cerr << "Failed to open file " << filename.data() << '\n';
-        std::exit(74);// I/O error
+        return false;
     }
-    std::string buffer;
     buffer.resize(file.tellg());
     file.seekg(0, std::ios::beg);
     file.read(buffer.data(), buffer.size());
     file.close();
+    return true;
+}
 
+std::string readFile(std::string_view filename) {
+    std::string buffer;
+    if (!readSource(filename, buffer)) {
+        std::cerr << "Failed to open file " << filename.data() << '\n';
+        std::exit(74);// I/O error
+    }
     return buffer;
 }
 
 void lox::runFile(string path) {
     std::string source = readFile(path);
-    run(source);
+    RunContext context;
+    run(context, source);
 
-    if (Error::hadError)
+    if (context.errors.hadError)
         exit(65);
-    if (Error::hadRuntimeError)
+    if (context.errors.hadRuntimeError)
         exit(70);
 }
 
-void lox::buildFile(string path) {
+void lox::buildFile(string path, unsigned jobs) {
     std::string source = readFile(path);
-    build(source);
+    build(source, path, jobs);
     // printf("build file, generate llvm IR\n");
 }
+/// @brief run the script with the interpreter and write <script>.loxprof,
+/// which later builds of the same script pick up
+void lox::profileFile(string path) {
+    std::string source = readFile(path);
+    auto profile = std::make_shared<Profile>(source);
+    RunContext context;
+    run(context, source, profile);
+    if (!profile->save(path + ".loxprof")) {
+        std::cerr << "Failed to write profile " << path << ".loxprof\n";
+    }
+
+    if (context.errors.hadError)
+        exit(65);
+    if (context.errors.hadRuntimeError)
+        exit(70);
+}
+
+/// @brief parse `run-batch [-j jobs] [script | @manifest]...`, a manifest
+/// lists one script per line, blank lines and lines starting with # are skipped
+void lox::batchCommand(int argc, const char *argv[]) {
+    unsigned jobs = 0;
+    vector<string> paths;
+    for (int i = 2; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "-j") {
+            if (i + 1 == argc || !parseJobs(argv[++i], jobs)) {
+                usage();
+                exit(64);
+            }
+        } else if (arg.size() > 1 && arg[0] == '@') {
+            std::ifstream manifest(arg.substr(1));
+            if (!manifest) {
+                std::cerr << "Failed to open manifest " << arg.substr(1) << '\n';
+                exit(74);
+            }
+            for (string line; std::getline(manifest, line);) {
+                if (!line.empty() && line.back() == '\r') {
+                    line.pop_back();
+                }
+                if (!line.empty() && line[0] != '#') {
+                    paths.push_back(line);
+                }
+            }
+        } else {
+            paths.push_back(arg);
+        }
+    }
+    exit(batchFiles(paths, jobs) == 0 ? 0 : 1);
+}
+
+/// @brief run one script of a batch in its own context, with its output
+/// and errors captured
+lox::BatchResult lox::runIsolated(const string &path) {
+    BatchResult result;
+    auto begin = std::chrono::steady_clock::now();
+    std::string source;
+    if (!readSource(path, source)) {
+        result.errors = "Failed to open file " + path + "\n";
+        result.status = 74;
+    } else {
+        OutputBuffer output(result.output);
+        std::ostringstream diagnostics;
+        RunContext context(output, diagnostics);
+        try {
+            run(context, source);
+        } catch (const std::exception &error) {
+            // a crash of one script must not take the whole batch down
+            context.output.flush();
+            diagnostics << "Fatal error: " << error.what() << '\n';
+            context.errors.hadRuntimeError = true;
+        }
+        output.flush();
+        result.errors = diagnostics.str();
+        result.status = context.errors.hadError ? 65 : context.errors.hadRuntimeError ? 70 : 0;
+    }
+    result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+    return result;
+}
+
+/// @brief run the scripts on a pool of jobs threads (one per core when 0)
+/// and print each script's output, exit status and time in the given order,
+/// returns the number of scripts that failed
+size_t lox::batchFiles(const vector<string> &paths, unsigned jobs) {
+    if (jobs == 0) {
+        jobs = std::max(1u, std::thread::hardware_concurrency());
+    }
+    jobs = static_cast<unsigned>(std::max<size_t>(1, std::min<size_t>(jobs, paths.size())));
+
+    auto &output = OutputBuffer::standard();
+    vector<BatchResult> results(paths.size());
+    vector<bool> finished(paths.size(), false);
+    std::atomic<size_t> next{0};
+    std::mutex lock;
+    size_t printed = 0;
+    size_t failed = 0;
+    char line[64];
+
+    auto begin = std::chrono::steady_clock::now();
+    auto worker = [&] {
+        for (size_t i; (i = next.fetch_add(1)) < paths.size();) {
+            BatchResult result = runIsolated(paths[i]);
+            std::lock_guard<std::mutex> guard(lock);
+            results[i] = std::move(result);
+            finished[i] = true;
+            // print as soon as every script before this one is printed
+            for (; printed < paths.size() && finished[printed]; printed++) {
+                BatchResult &done = results[printed];
+                std::snprintf(line, sizeof(line), ": exit %d, %.3f ms", done.status, done.milliseconds);
+                output.write("==> ");
+                output.write(paths[printed]);
+                output.write(line);
+                output.endLine();
+                output.write(done.output);
+                output.write(done.errors);
+                failed += done.status != 0;
+                done = BatchResult{};
+            }
+        }
+    };
+    vector<std::thread> threads;
+    for (unsigned i = 1; i < jobs; i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread: threads) {
+        thread.join();
+    }
+
+    double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+    std::snprintf(line, sizeof(line), "%zu scripts, %zu failed, %.3f ms on %u threads", paths.size(), failed, elapsed, jobs);
+    output.write(line);
+    output.endLine();
+    output.flush();
+    return failed;
+}
+
+std::shared_ptr<Profile> lox::loadProfile(const string &source, const string &path) {
+    auto profile = std::make_shared<Profile>(source);
+    std::ifstream file(path + ".loxprof");
+    if (!file) {
+        return nullptr;
+    }
+    if (!profile->load(path + ".loxprof")) {
+        std::cerr << "[LoxVM]: profile " << path << ".loxprof does not match the script, ignored\n";
+        return nullptr;
+    }
+    return profile;
+}
+
+void lox::jitFile(string path, unsigned jobs) {
+    std::string source = readFile(path);
+    exit(jit(source, path, jobs));
+}
+
 void lox::runPrompt() {
     string input;
+    RunContext context;
     while (1) {
-        std::cout << "> ";
+        context.output.write("> ");
+        context.output.flush();
         std::string line;
         if (!std::getline(std::cin, line)) {
             return;
         }
 
-        run(line);
-        Error::hadError = false;
+        run(context, line);
+        context.errors.clear();
     }
 }
 
-void lox::run(string source) {
-    shared_ptr<Scanner> scanner = std::make_shared<Scanner>(source);
+/// @brief run a script with the interpreter; errors and output go to the
+/// context, nothing is shared with other runs
+void lox::run(RunContext &context, string source, std::shared_ptr<Profile> profile) {
+    shared_ptr<Scanner> scanner = std::make_shared<Scanner>(source, context.errors);
     vector<Token> tokens = scanner->scanTokens();
-    shared_ptr<Parser> parser = std::make_shared<Parser>(tokens);
+    shared_ptr<Parser> parser = std::make_shared<Parser>(tokens, context.errors);
     vector<shared_ptr<Stmt>> statements = parser->parse();
     // Stop if there was a syntax error.
-    if (Error::hadError) {
-        Error::report();
+    if (context.errors.hadError) {
+        context.errors.report(context.diagnostics);
         return;
     }
 
     if (statements.size() == 0) {
-        cout << "no value" << endl;
+        context.output.write("no value");
+        context.output.endLine();
     } else {
-        shared_ptr<Interpreter> interpreter = std::make_shared<Interpreter>();
+        shared_ptr<Interpreter> interpreter = std::make_shared<Interpreter>(context);
+        interpreter->profile = profile;
         shared_ptr<Resolver> resolver = std::make_shared<Resolver>(interpreter);
         resolver->resolve(statements);
         // Stop if there was a resolution error.
-        if (Error::hadError) {
-            Error::report();
+        if (context.errors.hadError) {
+            context.errors.report(context.diagnostics);
             return;
         }
 
         interpreter->interpret(statements);
-        if (Error::hadRuntimeError) {
-            Error::report();
+        if (context.errors.hadRuntimeError) {
+            // keep the script's output in front of the error message
+            context.output.flush();
+            context.errors.report(context.diagnostics);
             return;
         }
     }
 }
 
-void lox::build(string source) {
-    shared_ptr<Scanner> scanner = std::make_shared<Scanner>(source);
+/// @brief the native code cache is off unless LOX_CACHE_DIR names a directory
+string lox::cacheDirectory() {
+    const char *cacheDir = std::getenv("LOX_CACHE_DIR");
+    return cacheDir != nullptr ? cacheDir : "";
+}
+
+void lox::build(string source, const string &path, unsigned jobs) {
+    RunContext context;
+    shared_ptr<Scanner> scanner = std::make_shared<Scanner>(source, context.errors);
     vector<Token> tokens = scanner->scanTokens();
-    shared_ptr<Parser> parser = std::make_shared<Parser>(tokens);
+    shared_ptr<Parser> parser = std::make_shared<Parser>(tokens, context.errors);
     vector<shared_ptr<Stmt>> statements = parser->parse();
 
-    shared_ptr<LoxVM> vm = std::make_shared<LoxVM>();
+    shared_ptr<LoxVM> vm = std::make_shared<LoxVM>(jobs, cacheDirectory());
+    vm->setProfile(loadProfile(source, path));
     vm->exec(statements);
 }
+
+int lox::jit(string source, const string &path, unsigned jobs) {
+    RunContext context;
+    shared_ptr<Scanner> scanner = std::make_shared<Scanner>(source, context.errors);
+    vector<Token> tokens = scanner->scanTokens();
+    shared_ptr<Parser> parser = std::make_shared<Parser>(tokens, context.errors);
+    vector<shared_ptr<Stmt>> statements = parser->parse();
+    if (context.errors.hadError) {
+        context.errors.report(context.diagnostics);
+        return 65;
+    }
+
+    shared_ptr<LoxVM> vm = std::make_shared<LoxVM>(jobs, cacheDirectory());
+    vm->setProfile(loadProfile(source, path));
+    return vm->jit(statements, path);
+}
@@ -0,0 +1,251 @@
+#include "../../include/ArrayKernels.hpp"
+#include <algorithm>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define LOX_AVX2_KERNELS 1
+#endif
+
+namespace {
+#ifdef LOX_AVX2_KERNELS
+    bool useAvx2() {
+        static const bool supported = __builtin_cpu_supports("avx2");
+        return supported;
+    }
+
+    double horizontalSum(__m256d v) __attribute__((target("avx2")));
+    double horizontalSum(__m256d v) {
+        alignas(32) double lanes[4];
+        _mm256_store_pd(lanes, v);
+        return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    }
+
+    __attribute__((target("avx2"))) double sumAvx2(const double *a, size_t n) {
+        // two accumulators hide the latency of the adds
+        __m256d acc0 = _mm256_setzero_pd();
+        __m256d acc1 = _mm256_setzero_pd();
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(a + i));
+            acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(a + i + 4));
+        }
+        for (; i + 4 <= n; i += 4) {
+            acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(a + i));
+        }
+        double total = horizontalSum(_mm256_add_pd(acc0, acc1));
+        for (; i < n; i++) {
+            total += a[i];
+        }
+        return total;
+    }
+
+    __attribute__((target("avx2"))) double dotAvx2(const double *a, const double *b, size_t n) {
+        __m256d acc0 = _mm256_setzero_pd();
+        __m256d acc1 = _mm256_setzero_pd();
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+            acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4)));
+        }
+        for (; i + 4 <= n; i += 4) {
+            acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+        }
+        double total = horizontalSum(_mm256_add_pd(acc0, acc1));
+        for (; i < n; i++) {
+            total += a[i] * b[i];
+        }
+        return total;
+    }
+
+    __attribute__((target("avx2"))) double minAvx2(const double *a, size_t n) {
+        size_t i = 0;
+        double result = a[0];
+        if (n >= 4) {
+            __m256d acc = _mm256_loadu_pd(a);
+            for (i = 4; i + 4 <= n; i += 4) {
+                acc = _mm256_min_pd(acc, _mm256_loadu_pd(a + i));
+            }
+            alignas(32) double lanes[4];
+            _mm256_store_pd(lanes, acc);
+            result = std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+        }
+        for (; i < n; i++) {
+            result = std::min(result, a[i]);
+        }
+        return result;
+    }
+
+    __attribute__((target("avx2"))) double maxAvx2(const double *a, size_t n) {
+        size_t i = 0;
+        double result = a[0];
+        if (n >= 4) {
+            __m256d acc = _mm256_loadu_pd(a);
+            for (i = 4; i + 4 <= n; i += 4) {
+                acc = _mm256_max_pd(acc, _mm256_loadu_pd(a + i));
+            }
+            alignas(32) double lanes[4];
+            _mm256_store_pd(lanes, acc);
+            result = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+        }
+        for (; i < n; i++) {
+            result = std::max(result, a[i]);
+        }
+        return result;
+    }
+
+    __attribute__((target("avx2"))) void scaleAvx2(double *a, size_t n, double factor) {
+        __m256d k = _mm256_set1_pd(factor);
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            _mm256_storeu_pd(a + i, _mm256_mul_pd(_mm256_loadu_pd(a + i), k));
+        }
+        for (; i < n; i++) {
+            a[i] *= factor;
+        }
+    }
+
+    __attribute__((target("avx2"))) void addAvx2(double *a, const double *b, size_t n) {
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            _mm256_storeu_pd(a + i, _mm256_add_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+        }
+        for (; i < n; i++) {
+            a[i] += b[i];
+        }
+    }
+
+    __attribute__((target("avx2"))) int64_t sumAvx2(const int64_t *a, size_t n) {
+        __m256i acc = _mm256_setzero_si256();
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            acc = _mm256_add_epi64(acc, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i)));
+        }
+        alignas(32) int64_t lanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), acc);
+        int64_t total = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+        for (; i < n; i++) {
+            total += a[i];
+        }
+        return total;
+    }
+
+    template<bool Min>
+    __attribute__((target("avx2"))) int64_t extremeAvx2(const int64_t *a, size_t n) {
+        size_t i = 0;
+        int64_t result = a[0];
+        if (n >= 4) {
+            __m256i acc = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a));
+            for (i = 4; i + 4 <= n; i += 4) {
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+                // there is no 64-bit min/max before AVX-512, select with a compare
+                __m256i greater = _mm256_cmpgt_epi64(acc, v);
+                acc = Min ? _mm256_blendv_epi8(acc, v, greater) : _mm256_blendv_epi8(v, acc, greater);
+            }
+            alignas(32) int64_t lanes[4];
+            _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), acc);
+            result = lanes[0];
+            for (int lane = 1; lane < 4; lane++) {
+                result = Min ? std::min(result, lanes[lane]) : std::max(result, lanes[lane]);
+            }
+        }
+        for (; i < n; i++) {
+            result = Min ? std::min(result, a[i]) : std::max(result, a[i]);
+        }
+        return result;
+    }
+
+    __attribute__((target("avx2"))) void addAvx2(int64_t *a, const int64_t *b, size_t n) {
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            auto va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+            auto vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(a + i), _mm256_add_epi64(va, vb));
+        }
+        for (; i < n; i++) {
+            a[i] += b[i];
+        }
+    }
+#endif
+
+    template<typename T>
+    T sumScalar(const T *a, size_t n) {
+        T total = 0;
+        for (size_t i = 0; i < n; i++) {
+            total += a[i];
+        }
+        return total;
+    }
+
+    template<typename T>
+    T dotScalar(const T *a, const T *b, size_t n) {
+        T total = 0;
+        for (size_t i = 0; i < n; i++) {
+            total += a[i] * b[i];
+        }
+        return total;
+    }
+
+    template<typename T>
+    T minScalar(const T *a, size_t n) {
+        T result = a[0];
+        for (size_t i = 1; i < n; i++) {
+            result = std::min(result, a[i]);
+        }
+        return result;
+    }
+
+    template<typename T>
+    T maxScalar(const T *a, size_t n) {
+        T result = a[0];
+        for (size_t i = 1; i < n; i++) {
+            result = std::max(result, a[i]);
+        }
+        return result;
+    }
+
+    template<typename T>
+    void scaleScalar(T *a, size_t n, T factor) {
+        for (size_t i = 0; i < n; i++) {
+            a[i] *= factor;
+        }
+    }
+
+    template<typename T>
+    void addScalar(T *a, const T *b, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            a[i] += b[i];
+        }
+    }
+}
+
+#ifdef LOX_AVX2_KERNELS
+#define LOX_DISPATCH(avx2, scalar) return useAvx2() ? (avx2) : (scalar)
+#else
+#define LOX_DISPATCH(avx2, scalar) return (scalar)
+#endif
+
+namespace ArrayKernels {
+    double sum(const double *a, size_t n) { LOX_DISPATCH(sumAvx2(a, n), sumScalar(a, n)); }
+    double min(const double *a, size_t n) { LOX_DISPATCH(minAvx2(a, n), minScalar(a, n)); }
+    double max(const double *a, size_t n) { LOX_DISPATCH(maxAvx2(a, n), maxScalar(a, n)); }
+    double dot(const double *a, const double *b, size_t n) { LOX_DISPATCH(dotAvx2(a, b, n), dotScalar(a, b, n)); }
+    void scale(double *a, size_t n, double factor) { LOX_DISPATCH(scaleAvx2(a, n, factor), scaleScalar(a, n, factor)); }
+    void add(double *a, const double *b, size_t n) { LOX_DISPATCH(addAvx2(a, b, n), addScalar(a, b, n)); }
+
+    void fill(double *a, size_t n, double value) {
+        std::fill(a, a + n, value);
+    }
+
+    int64_t sum(const int64_t *a, size_t n) { LOX_DISPATCH(sumAvx2(a, n), sumScalar(a, n)); }
+    int64_t min(const int64_t *a, size_t n) { LOX_DISPATCH(extremeAvx2<true>(a, n), minScalar(a, n)); }
+    int64_t max(const int64_t *a, size_t n) { LOX_DISPATCH(extremeAvx2<false>(a, n), maxScalar(a, n)); }
+    void add(int64_t *a, const int64_t *b, size_t n) { LOX_DISPATCH(addAvx2(a, b, n), addScalar(a, b, n)); }
+
+    // AVX2 has no 64-bit multiply, the compiler's scalar code is as good
+    int64_t dot(const int64_t *a, const int64_t *b, size_t n) { return dotScalar(a, b, n); }
+    void scale(int64_t *a, size_t n, int64_t factor) { scaleScalar(a, n, factor); }
+
+    void fill(int64_t *a, size_t n, int64_t value) {
+        std::fill(a, a + n, value);
+    }
+}
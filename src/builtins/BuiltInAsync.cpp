@@ -0,0 +1,516 @@
+#include "../../include/BuiltInAsync.hpp"
+#include "../../include/BuiltInFile.hpp"
+#include "../../include/BuiltInIo.hpp"
+#include "../../include/Generator.hpp"
+#include "../../include/Interpreter.hpp"
+#include "../../include/LoxClass.hpp"
+#include "../../include/LoxFunction.hpp"
+#include "../../include/LoxString.hpp"
+#include "../../include/NativeFunction.hpp"
+#include "../../include/RuntimeError.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <limits>
+#include <spawn.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <utility>
+#include <variant>
+
+extern char **environ;
+
+namespace {
+    /// @brief read or write the file of operation, on a helper thread
+    void transfer(EventLoop::Operation &operation) {
+        bool reading = operation.kind == EventLoop::Operation::Kind::Read;
+        int flags = reading ? O_RDONLY : O_WRONLY | O_CREAT | O_TRUNC;
+        int fd = ::open(operation.target.c_str(), flags | O_CLOEXEC, 0666);
+        if (fd < 0) {
+            operation.error = "Runtime Error. Could not open file '" + operation.target + "': " +
+                              std::strerror(errno) + ".";
+            return;
+        }
+        if (reading) {
+            struct stat info {};
+            size_t size = ::fstat(fd, &info) == 0 && info.st_size > 0 ? static_cast<size_t>(info.st_size) : 0;
+            if (int error = readDescriptor(fd, size, operation.data)) {
+                operation.error = "Runtime Error. Could not read file '" + operation.target + "': " +
+                                  std::strerror(error) + ".";
+            }
+            ::close(fd);
+            return;
+        }
+        size_t offset = 0;
+        while (offset < operation.data.size()) {
+            ssize_t count = ::write(fd, operation.data.data() + offset, operation.data.size() - offset);
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count < 0) {
+                operation.error = "Runtime Error. Could not write file '" + operation.target + "': " +
+                                  std::strerror(errno) + ".";
+                break;
+            }
+            offset += static_cast<size_t>(count);
+        }
+        ::close(fd);
+    }
+}
+
+// ------------------------------------------------------------------------------------------
+Object EventLoop::Operation::result() const {
+    if (kind == Kind::Read || kind == Kind::Process) {
+        return Object::make_obj(data);
+    }
+    return Object::make_nil_obj();
+}
+
+EventLoop::EventLoop(Interpreter &interpreter_) : interpreter(interpreter_) {
+    epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    eventFd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (epollFd < 0 || eventFd < 0) {
+        throw RuntimeError(string("Runtime Error. Could not start the event loop: ") + std::strerror(errno) + ".");
+    }
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = eventFd;
+    ::epoll_ctl(epollFd, EPOLL_CTL_ADD, eventFd, &event);
+}
+
+EventLoop::~EventLoop() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    work.notify_all();
+    for (auto &helper: helpers) {
+        helper.join();
+    }
+    for (auto &[fd, process]: processes) {
+        ::kill(process.pid, SIGKILL);
+        ::close(fd);
+        ::waitpid(process.pid, nullptr, 0);
+    }
+    ::close(eventFd);
+    ::close(epollFd);
+}
+
+EventLoop &EventLoop::of(Interpreter &interpreter) {
+    if (interpreter.events == nullptr) {
+        interpreter.events = std::make_shared<EventLoop>(interpreter);
+    }
+    return *interpreter.events;
+}
+
+void EventLoop::sleep(const shared_ptr<Operation> &operation, std::chrono::milliseconds delay) {
+    timers.push(Timer{std::chrono::steady_clock::now() + delay, timerSequence++, operation});
+    pending++;
+}
+
+void EventLoop::readFile(const shared_ptr<Operation> &operation) {
+    offload(operation);
+}
+
+void EventLoop::writeFile(const shared_ptr<Operation> &operation) {
+    offload(operation);
+}
+
+void EventLoop::exec(const shared_ptr<Operation> &operation) {
+    int fds[2];
+    if (::pipe2(fds, O_CLOEXEC) != 0) {
+        throw RuntimeError("Runtime Error. Could not run '" + operation->target + "': " + std::strerror(errno) + ".");
+    }
+    // dup2 clears close-on-exec, the child keeps only the write end as stdout
+    posix_spawn_file_actions_t actions;
+    ::posix_spawn_file_actions_init(&actions);
+    ::posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+    const char *argv[] = {"sh", "-c", operation->target.c_str(), nullptr};
+    pid_t pid;
+    int status = ::posix_spawn(&pid, "/bin/sh", &actions, nullptr, const_cast<char *const *>(argv), environ);
+    ::posix_spawn_file_actions_destroy(&actions);
+    ::close(fds[1]);
+    if (status != 0) {
+        ::close(fds[0]);
+        throw RuntimeError("Runtime Error. Could not run '" + operation->target + "': " + std::strerror(status) + ".");
+    }
+    ::fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = fds[0];
+    ::epoll_ctl(epollFd, EPOLL_CTL_ADD, fds[0], &event);
+    processes.emplace(fds[0], Process{pid, operation});
+    pending++;
+}
+
+void EventLoop::schedule(shared_ptr<Task> task) {
+    ready.push_back(std::move(task));
+}
+
+void EventLoop::await(const shared_ptr<Operation> &operation) {
+    if (operation->completed) {
+        return;
+    }
+    // only the task's own body suspends it, not a generator it resumed
+    if (current != nullptr && interpreter.runningGenerator() == current->body.get()) {
+        auto task = current;
+        operation->waiting.push_back(task);
+        task->waiting = true;
+        // back in resume(), the loop resumes the task once operation completed
+        task->body->yield(Object::make_nil_obj());
+        return;
+    }
+    while (!operation->completed) {
+        if (!runOnce()) {
+            throw RuntimeError("Runtime Error. Waiting for a task that can never finish.");
+        }
+    }
+}
+
+void EventLoop::run() {
+    while (runOnce()) {
+    }
+}
+
+/// @brief one turn: pick up completions, tell their waiters, then resume the
+/// tasks that are ready; false when there was nothing to do
+bool EventLoop::runOnce() {
+    if (ready.empty() && completed.empty()) {
+        if (pending == 0) {
+            return false;
+        }
+        poll(timeout());
+    } else if (pending > 0) {
+        // tasks that keep yielding must not starve the operations
+        poll(0);
+    }
+    // what the callbacks and tasks start runs in the next turn; a callback
+    // that waits runs turns of its own, so recheck before taking
+    for (size_t turn = completed.size(); turn > 0 && !completed.empty(); turn--) {
+        auto operation = std::move(completed.front());
+        completed.pop_front();
+        notify(operation);
+    }
+    for (size_t turn = ready.size(); turn > 0 && !ready.empty(); turn--) {
+        auto task = std::move(ready.front());
+        ready.pop_front();
+        resume(task);
+    }
+    return true;
+}
+
+/// @brief wait up to timeout milliseconds for operations to complete, -1
+/// waits until one does
+void EventLoop::poll(int timeout) {
+    epoll_event events[16];
+    int count = ::epoll_wait(epollFd, events, 16, timeout);
+    for (int i = 0; i < count; i++) {
+        int fd = events[i].data.fd;
+        if (fd != eventFd) {
+            readPipe(fd);
+            continue;
+        }
+        uint64_t signals;
+        ::read(eventFd, &signals, sizeof signals);
+        std::deque<shared_ptr<Operation>> finished;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            finished.swap(done);
+        }
+        for (auto &operation: finished) {
+            complete(std::move(operation));
+        }
+    }
+    auto now = std::chrono::steady_clock::now();
+    while (!timers.empty() && timers.top().deadline <= now) {
+        auto operation = timers.top().operation;
+        timers.pop();
+        complete(std::move(operation));
+    }
+}
+
+/// @brief milliseconds until the next timer is due, -1 without timers
+int EventLoop::timeout() const {
+    if (timers.empty()) {
+        return -1;
+    }
+    auto left = std::chrono::ceil<std::chrono::milliseconds>(timers.top().deadline - std::chrono::steady_clock::now());
+    // a far deadline waits as long as epoll can, and is checked again after
+    return static_cast<int>(std::clamp<long long>(left.count(), 0, std::numeric_limits<int>::max()));
+}
+
+void EventLoop::complete(shared_ptr<Operation> operation) {
+    operation->completed = true;
+    pending--;
+    completed.push_back(std::move(operation));
+}
+
+void EventLoop::notify(const shared_ptr<Operation> &operation) {
+    for (auto &task: operation->waiting) {
+        task->waiting = false;
+        ready.push_back(std::move(task));
+    }
+    operation->waiting.clear();
+    if (operation->callback == nullptr) {
+        return;
+    }
+    auto callback = std::move(operation->callback);
+    if (!operation->error.empty()) {
+        throw RuntimeError(operation->site, operation->error);
+    }
+    std::vector<Object> arguments;
+    if (operation->kind == Operation::Kind::Read || operation->kind == Operation::Kind::Process) {
+        arguments.push_back(operation->result());
+    }
+    callback->call(interpreter, Arguments(arguments));
+}
+
+/// @brief run the task's body until it yields, waits or finishes
+void EventLoop::resume(const shared_ptr<Task> &task) {
+    auto outer = std::move(current);
+    current = task;
+    try {
+        task->body->resume(interpreter, Object::make_nil_obj());
+    } catch (...) {
+        current = std::move(outer);
+        task->finished->completed = true;
+        throw;
+    }
+    current = std::move(outer);
+    if (task->body->isDone()) {
+        task->finished->completed = true;
+        completed.push_back(task->finished);
+    } else if (!task->waiting) {
+        // it yielded, the others get a turn first
+        ready.push_back(task);
+    }
+}
+
+void EventLoop::offload(const shared_ptr<Operation> &operation) {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        jobs.push_back(operation);
+        if (idleHelpers == 0 && helpers.size() < maxHelpers) {
+            helpers.emplace_back(&EventLoop::helperMain, this);
+        }
+    }
+    work.notify_one();
+    pending++;
+}
+
+void EventLoop::helperMain() {
+    std::unique_lock<std::mutex> guard(lock);
+    while (true) {
+        idleHelpers++;
+        work.wait(guard, [this] { return stopping || !jobs.empty(); });
+        idleHelpers--;
+        if (stopping) {
+            return;
+        }
+        // moved along, so the last reference to an operation, and to the Lox
+        // callback it holds, is always dropped on the interpreter's thread
+        auto operation = std::move(jobs.front());
+        jobs.pop_front();
+        guard.unlock();
+        transfer(*operation);
+        guard.lock();
+        done.push_back(std::move(operation));
+        uint64_t signal = 1;
+        ::write(eventFd, &signal, sizeof signal);
+    }
+}
+
+/// @brief take what the subprocess wrote, it completes at end of file
+void EventLoop::readPipe(int fd) {
+    auto &process = processes.at(fd);
+    auto &output = process.operation->data;
+    char buffer[64 * 1024];
+    while (true) {
+        ssize_t count = ::read(fd, buffer, sizeof buffer);
+        if (count > 0) {
+            output.append(buffer, static_cast<size_t>(count));
+            continue;
+        }
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count < 0 && errno == EAGAIN) {
+            return;
+        }
+        break;
+    }
+    ::epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    int status = 0;
+    while (::waitpid(process.pid, &status, 0) < 0 && errno == EINTR) {
+    }
+    auto operation = std::move(process.operation);
+    processes.erase(fd);
+    if (WIFEXITED(status) && WEXITSTATUS(status) != 0) {
+        operation->error = "Runtime Error. Command '" + operation->target + "' exited with status " +
+                           std::to_string(WEXITSTATUS(status)) + ".";
+    } else if (WIFSIGNALED(status)) {
+        operation->error = "Runtime Error. Command '" + operation->target + "' was killed by signal " +
+                           std::to_string(WTERMSIG(status)) + ".";
+    }
+    complete(std::move(operation));
+}
+
+// ------------------------------------------------------------------------------------------
+static Object taskWait(Interpreter &interpreter, LoxInstance &self, Arguments args) {
+    auto &task = static_cast<Task &>(self);
+    EventLoop::of(interpreter).await(task.finished);
+    return task.body->result();
+}
+
+static Object taskDone(Interpreter &interpreter, LoxInstance &self, Arguments args) {
+    return Object::make_obj(static_cast<Task &>(self).finished->completed);
+}
+
+static const shared_ptr<LoxClass> &taskClass() {
+    static const auto klass = [] {
+        auto task = std::make_shared<LoxClass>("Task", nullptr, map<string, shared_ptr<LoxFunction>>{});
+        task->nativeMethods["wait"] = std::make_shared<NativeMethod>("wait", 0, taskWait);
+        task->nativeMethods["done"] = std::make_shared<NativeMethod>("done", 0, taskDone);
+        return task;
+    }();
+    return klass;
+}
+
+Task::Task(shared_ptr<Generator> body_)
+    : LoxInstance(taskClass()), body(std::move(body_)),
+      finished(std::make_shared<EventLoop::Operation>(EventLoop::Operation::Kind::Task)) {}
+
+// ------------------------------------------------------------------------------------------
+namespace {
+    using Operation = EventLoop::Operation;
+
+    void expectArguments(Arguments args, size_t least, size_t most) {
+        if (args.size() < least || args.size() > most) {
+            throw RuntimeError("Runtime Error. Expected " + std::to_string(least) + " or " + std::to_string(most) +
+                               " arguments but got " + std::to_string(args.size()) + ".");
+        }
+    }
+
+    /// @brief an operation started by the native being called
+    shared_ptr<Operation> newOperation(Interpreter &interpreter, Operation::Kind kind, std::string target = "") {
+        auto operation = std::make_shared<Operation>(kind, std::move(target));
+        if (interpreter.callSite != nullptr) {
+            operation->site = *interpreter.callSite;
+        }
+        return operation;
+    }
+
+    /// @brief the callback argument of native, called with arity arguments
+    shared_ptr<LoxCallable> callbackArgument(const Object &argument, const char *native, size_t arity) {
+        if (!std::holds_alternative<shared_ptr<LoxCallable>>(argument.data)) {
+            throw RuntimeError(string("Runtime Error. The callback of ") + native + " must be a function.");
+        }
+        auto callback = std::get<shared_ptr<LoxCallable>>(argument.data);
+        if (callback->arity() != arity && callback->arity() != LoxCallable::VARIADIC) {
+            throw RuntimeError(string("Runtime Error. The callback of ") + native + " must take " +
+                               std::to_string(arity) + (arity == 1 ? " argument." : " arguments."));
+        }
+        return callback;
+    }
+
+    /// @brief nil when operation has a callback, otherwise wait for its result
+    Object resultOf(EventLoop &loop, const shared_ptr<Operation> &operation) {
+        if (operation->callback != nullptr) {
+            return Object::make_nil_obj();
+        }
+        loop.await(operation);
+        if (!operation->error.empty()) {
+            throw RuntimeError(operation->error);
+        }
+        return operation->result();
+    }
+}
+
+Object nativeReadFile(Interpreter &interpreter, Arguments args) {
+    expectArguments(args, 1, 2);
+    auto operation = newOperation(interpreter, Operation::Kind::Read, stringArgument(args[0], "File path"));
+    if (args.size() == 2) {
+        operation->callback = callbackArgument(args[1], "readFile", 1);
+    }
+    auto &loop = EventLoop::of(interpreter);
+    loop.readFile(operation);
+    return resultOf(loop, operation);
+}
+
+Object nativeWriteFile(Interpreter &interpreter, Arguments args) {
+    expectArguments(args, 2, 3);
+    auto operation = newOperation(interpreter, Operation::Kind::Write, stringArgument(args[0], "File path"));
+    stringify(args[1], operation->data);
+    if (args.size() == 3) {
+        operation->callback = callbackArgument(args[2], "writeFile", 0);
+    }
+    auto &loop = EventLoop::of(interpreter);
+    loop.writeFile(operation);
+    return resultOf(loop, operation);
+}
+
+Object nativeSleep(Interpreter &interpreter, Arguments args) {
+    expectArguments(args, 1, 2);
+    double milliseconds;
+    if (std::holds_alternative<int>(args[0].data)) {
+        milliseconds = std::get<int>(args[0].data);
+    } else if (std::holds_alternative<double>(args[0].data)) {
+        milliseconds = std::get<double>(args[0].data);
+    } else {
+        throw RuntimeError("Runtime Error. sleep expects a number of milliseconds.");
+    }
+    auto operation = newOperation(interpreter, Operation::Kind::Timer);
+    if (args.size() == 2) {
+        operation->callback = callbackArgument(args[1], "sleep", 0);
+    }
+    auto &loop = EventLoop::of(interpreter);
+    // NaN waits for nothing, and the cast is only defined for values a long long holds
+    constexpr double longest = 1e15;// about 31000 years
+    milliseconds = std::isnan(milliseconds) ? 0 : std::clamp(milliseconds, 0.0, longest);
+    loop.sleep(operation, std::chrono::milliseconds(static_cast<long long>(milliseconds)));
+    return resultOf(loop, operation);
+}
+
+Object nativeExec(Interpreter &interpreter, Arguments args) {
+    expectArguments(args, 1, 2);
+    auto operation = newOperation(interpreter, Operation::Kind::Process, stringArgument(args[0], "Command"));
+    if (args.size() == 2) {
+        operation->callback = callbackArgument(args[1], "exec", 1);
+    }
+    auto &loop = EventLoop::of(interpreter);
+    loop.exec(operation);
+    return resultOf(loop, operation);
+}
+
+Object nativeTask(Interpreter &interpreter, Arguments args) {
+    shared_ptr<Generator> body;
+    if (!args.empty() && std::holds_alternative<shared_ptr<LoxInstance>>(args[0].data)) {
+        body = std::dynamic_pointer_cast<Generator>(std::get<shared_ptr<LoxInstance>>(args[0].data));
+        if (body != nullptr && args.size() != 1) {
+            throw RuntimeError("Runtime Error. Expected 1 argument but got " + std::to_string(args.size()) + ".");
+        }
+    } else if (!args.empty() && std::holds_alternative<shared_ptr<LoxCallable>>(args[0].data)) {
+        auto function = std::dynamic_pointer_cast<LoxFunction>(std::get<shared_ptr<LoxCallable>>(args[0].data));
+        if (function != nullptr) {
+            if (args.size() - 1 != function->arity()) {
+                throw RuntimeError("Runtime Error. Expected " + std::to_string(function->arity()) +
+                                   " arguments but got " + std::to_string(args.size() - 1) + ".");
+            }
+            std::vector<Object> arguments(args.begin() + 1, args.end());
+            body = function->coroutine(Arguments(arguments));
+        }
+    }
+    if (body == nullptr) {
+        throw RuntimeError("Runtime Error. task expects a function or a generator.");
+    }
+    auto task = std::make_shared<Task>(std::move(body));
+    EventLoop::of(interpreter).schedule(task);
+    return Object::make_instance_obj(task);
+}
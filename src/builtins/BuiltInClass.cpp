@@ -1,79 +1,365 @@
 #include "../../include/BuiltInClass.hpp"
+#include "../../include/BuiltInIo.hpp"
 #include "../../include/LoxList.hpp"
+#include "../../include/LoxString.hpp"
+#include "../../include/NativeFunction.hpp"
+#include "../../include/ParallelSort.hpp"
 #include "../../include/RuntimeError.hpp"
 #include "../../include/Stmt.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <iostream>
+#include <iterator>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <utility>
 
+// ------------------------------------------------------------------------------------------
+static LoxList &listOf(LoxInstance &self) {
+    return static_cast<ListInstance &>(self).list();
+}
+
+static Object listLen(Interpreter &interpreter, LoxInstance &self, Arguments args) {
+    return Object::make_obj(double(listOf(self).length()));
+}
+
+static Object listAppend(Interpreter &interpreter, LoxInstance &self, Arguments args) {
+    listOf(self).append(args[0]);
+    return Object::make_nil_obj();
+}
+
+static bool isNumber(const Object &value) {
+    return std::holds_alternative<double>(value.data) || std::holds_alternative<int>(value.data);
+}
+
+static double numberOf(const Object &value) {
+    return std::holds_alternative<int>(value.data) ? std::get<int>(value.data) : std::get<double>(value.data);
+}
+
+static bool isString(const Object &value) {
+    return std::holds_alternative<shared_ptr<LoxString>>(value.data);
+}
+
+// nan sorts after every other number
+static bool numberLess(double a, double b) {
+    return a < b || (std::isnan(b) && !std::isnan(a));
+}
+
+/// @brief sort by keys extracted from the elements, ties keep their order
+template<typename Key>
+static void sortByKey(std::vector<Object> &values, Key (*key)(const Object &), bool (*less)(Key, Key)) {
+    std::vector<std::pair<Key, uint32_t>> keyed;
+    keyed.reserve(values.size());
+    for (size_t i = 0; i < values.size(); i++) {
+        keyed.emplace_back(key(values[i]), static_cast<uint32_t>(i));
+    }
+    // plain keys instead of Objects, so the runs can be sorted on other threads
+    parallelSort(keyed, [less](const std::pair<Key, uint32_t> &a, const std::pair<Key, uint32_t> &b) {
+        if (less(a.first, b.first)) {
+            return true;
+        }
+        return !less(b.first, a.first) && a.second < b.second;
+    });
+    std::vector<Object> sorted;
+    sorted.reserve(values.size());
+    for (const auto &entry: keyed) {
+        sorted.push_back(std::move(values[entry.second]));
+    }
+    values.swap(sorted);
+}
+
+static std::string_view stringKey(const Object &value) {
+    return std::get<shared_ptr<LoxString>>(value.data)->str();
+}
+
+static bool stringLess(std::string_view a, std::string_view b) {
+    return a < b;
+}
+
+/// @brief sort with a Lox function, comparator(a, b) returns true or a
+/// negative number when a goes before b
+static void sortWithComparator(Interpreter &interpreter, LoxList &list, const Object &comparator) {
+    if (!std::holds_alternative<shared_ptr<LoxCallable>>(comparator.data)) {
+        throw RuntimeError("Runtime Error. sort comparator must be a function.");
+    }
+    auto callable = std::get<shared_ptr<LoxCallable>>(comparator.data);
+    if (callable->arity() != 2 && callable->arity() != LoxCallable::VARIADIC) {
+        throw RuntimeError("Runtime Error. sort comparator must take 2 arguments.");
+    }
+    // the comparator may change the list, sort a snapshot of it instead
+    auto snapshot = list.slice(0, list.length());
+    std::vector<uint32_t> order(snapshot->length());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = static_cast<uint32_t>(i);
+    }
+    std::vector<Object> pair;
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        // calls move their arguments out, refill the pair every time
+        pair.assign({snapshot->get(static_cast<int>(a)), snapshot->get(static_cast<int>(b))});
+        Object result = callable->call(interpreter, Arguments(pair));
+        if (std::holds_alternative<bool>(result.data)) {
+            return std::get<bool>(result.data);
+        }
+        if (isNumber(result)) {
+            return numberOf(result) < 0;
+        }
+        throw RuntimeError("Runtime Error. sort comparator must return a boolean or a number.");
+    });
+    std::vector<Object> sorted;
+    sorted.reserve(order.size());
+    for (uint32_t index: order) {
+        sorted.push_back(snapshot->get(static_cast<int>(index)));
+    }
+    list.assign(std::move(sorted));
+}
+
+// sort() orders numbers or strings, sort(comparator) anything
+static Object listSort(Interpreter &interpreter, LoxInstance &self, Arguments args) {
+    if (args.size() > 1) {
+        throw RuntimeError("Runtime Error. Expected 0 or 1 arguments but got " + std::to_string(args.size()) + ".");
+    }
+    LoxList &list = listOf(self);
+    if (args.size() == 1) {
+        sortWithComparator(interpreter, list, args[0]);
+        return Object::make_nil_obj();
+    }
+    if (std::all_of(list.begin(), list.end(), isNumber)) {
+        auto values = list.take();
+        sortByKey(values, numberOf, numberLess);
+        list.assign(std::move(values));
+    } else if (std::all_of(list.begin(), list.end(), isString)) {
+        auto values = list.take();
+        sortByKey(values, stringKey, stringLess);
+        list.assign(std::move(values));
+    } else {
+        throw RuntimeError("Runtime Error. sort() needs a list of numbers or strings, pass a comparator for other values.");
+    }
+    return Object::make_nil_obj();
+}
+
+// the index of value in a list sorted by sort(), or -1
+static Object listBinarySearch(Interpreter &interpreter, LoxInstance &self, Arguments args) {
+    const LoxList &list = listOf(self);
+    const Object &value = args[0];
+    const Object *found = nullptr;
+    if (isNumber(value)) {
+        double key = numberOf(value);
+        found = std::lower_bound(list.begin(), list.end(), key, [](const Object &element, double key) {
+            if (!isNumber(element)) {
+                throw RuntimeError("Runtime Error. binarySearch() needs a sorted list of numbers.");
+            }
+            return numberLess(numberOf(element), key);
+        });
+        if (found != list.end() && (numberLess(key, numberOf(*found)) || numberLess(numberOf(*found), key))) {
+            found = list.end();
+        }
+    } else if (isString(value)) {
+        std::string_view key = stringKey(value);
+        found = std::lower_bound(list.begin(), list.end(), key, [](const Object &element, std::string_view key) {
+            if (!isString(element)) {
+                throw RuntimeError("Runtime Error. binarySearch() needs a sorted list of strings.");
+            }
+            return stringKey(element) < key;
+        });
+        if (found != list.end() && stringKey(*found) != key) {
+            found = list.end();
+        }
+    } else {
+        throw RuntimeError("Runtime Error. binarySearch() looks for a number or a string.");
+    }
+    return Object::make_obj(found == list.end() ? -1.0 : double(found - list.begin()));
+}
+
+static Object listReverse(Interpreter &interpreter, LoxInstance &self, Arguments args) {
+    listOf(self).reverse();
+    return Object::make_nil_obj();
+}
+
+// the index of the first element equal to value, or -1
+static Object listIndexOf(Interpreter &interpreter, LoxInstance &self, Arguments args) {
+    const LoxList &list = listOf(self);
+    for (const Object *element = list.begin(); element != list.end(); ++element) {
+        if (interpreter.isEqual(*element, args[0])) {
+            return Object::make_obj(double(element - list.begin()));
+        }
+    }
+    return Object::make_obj(-1.0);
+}
+
+// appends the elements of a list() or a [...] list
+static Object listExtend(Interpreter &interpreter, LoxInstance &self, Arguments args) {
+    const Object &other = args[0];
+    if (std::holds_alternative<shared_ptr<LoxList>>(other.data)) {
+        listOf(self).extend(*std::get<shared_ptr<LoxList>>(other.data));
+        return Object::make_nil_obj();
+    }
+    if (std::holds_alternative<shared_ptr<LoxInstance>>(other.data)) {
+        if (auto instance = dynamic_cast<ListInstance *>(std::get<shared_ptr<LoxInstance>>(other.data).get())) {
+            listOf(self).extend(instance->list());
+            return Object::make_nil_obj();
+        }
+    }
+    throw RuntimeError("Runtime Error. extend() needs a list.");
+}
 // ------------------------------------------------------------------------------------------
 ListClass::ListClass() : LoxClass("list", nullptr, {}) {
-    this->methods["len"] = std::make_shared<ListLenMethods>(
-        std::make_shared<Environment>(),
-        std::make_shared<Function>(Token(), vector<std::pair<Token, string>>{}, vector<shared_ptr<Stmt>>{}, Token())
-    );
-    this->methods["append"] = std::make_shared<ListAppendMethods>(
-        std::make_shared<Environment>(),
-        std::make_shared<Function>(Token(), vector<std::pair<Token, string>>{{Token(), ""}}, vector<shared_ptr<Stmt>>{}, Token())
-    );
+    this->nativeMethods["len"] = std::make_shared<NativeMethod>("len", 0, listLen);
+    this->nativeMethods["append"] = std::make_shared<NativeMethod>("append", 1, listAppend);
+    this->nativeMethods["sort"] = std::make_shared<NativeMethod>("sort", VARIADIC, listSort);
+    this->nativeMethods["binarySearch"] = std::make_shared<NativeMethod>("binarySearch", 1, listBinarySearch);
+    this->nativeMethods["reverse"] = std::make_shared<NativeMethod>("reverse", 0, listReverse);
+    this->nativeMethods["indexOf"] = std::make_shared<NativeMethod>("indexOf", 1, listIndexOf);
+    this->nativeMethods["extend"] = std::make_shared<NativeMethod>("extend", 1, listExtend);
 }
 
 ListClass::ListClass(map<string, shared_ptr<LoxFunction>> methods_)
     : LoxClass("list", nullptr, std::move(methods_)) {}
 
-Object ListClass::call(shared_ptr<Interpreter> interpreter, std::vector<Object> args) {
-    //   return
-    //   Object::make_list_obj(std::make_shared<LoxList>(std::move(args)));
-    this->list = args;
-    auto list_instance = std::make_shared<ListInstance>(*this);
+/// @brief the arguments are moved into the new list, not copied
+Object ListClass::call(Interpreter &interpreter, Arguments args) {
+    std::vector<Object> values(std::make_move_iterator(args.begin()), std::make_move_iterator(args.end()));
+    auto list_instance = std::make_shared<ListInstance>(shared_from_this(), std::make_shared<LoxList>(std::move(values)));
     return Object::make_instance_obj(list_instance);
 }
+
+// list(...) takes the initial elements
+size_t ListClass::arity() { return VARIADIC; }
 // ------------------------------------------------------------------------------------------
-ListInstance::ListInstance(ListClass klass) : LoxInstance(klass) {
+ListInstance::ListInstance(shared_ptr<LoxClass> klass, shared_ptr<LoxList> values)
+    : LoxInstance(std::move(klass)) {
     this->fields.emplace("type", Object::make_obj("List-instance"));
-    this->fields.emplace(
-        "value", Object::make_obj(std::make_shared<LoxList>(klass.getList()))
-    );
+    this->fields.emplace("value", Object::make_obj(std::move(values)));
+}
+
+LoxList &ListInstance::list() {
+    return *std::get<shared_ptr<LoxList>>(this->fields["value"].data);
+}
+
+static int listIndex(const LoxList &list, const Object &key) {
+    // compared as doubles, a cast of an index outside int's range is undefined
+    if (!isNumber(key) || numberOf(key) != std::floor(numberOf(key))) {
+        throw RuntimeError("Runtime Error. Indices must be integers.");
+    }
+    double index = numberOf(key);
+    double length = static_cast<double>(list.length());
+    if (index >= length || index < -length) {
+        std::string shown;
+        stringify(key, shown);
+        throw RuntimeError("Runtime Error. Index out of range. Index is " + shown + " but object size is " +
+                           std::to_string(list.length()));
+    }
+    return static_cast<int>(index);
+}
+
+Object ListInstance::getIndex(const Object &key) {
+    return list().get(listIndex(list(), key));
+}
+
+void ListInstance::setIndex(const Object &key, Object value) {
+    list().at(listIndex(list(), key)) = std::move(value);
 }
 // ------------------------------------------------------------------------------------------
-ListLenMethods::ListLenMethods(shared_ptr<Environment> closure_, shared_ptr<Function> declaration_)
-    : LoxFunction(declaration_, closure_, false) {}
-
-Object ListLenMethods::call(shared_ptr<Interpreter> interpreter, std::vector<Object> args) {
-    size_t length =
-        std::get<shared_ptr<LoxList>>(std::get<shared_ptr<LoxInstance>>(
-                                          this->closure->getValues()["this"].data
-                                      )
-                                          ->fields["value"]
-                                          .data)
-            ->length();
-    return Object::make_obj(double(length));
-}
-
-shared_ptr<ListLenMethods>
-ListLenMethods::bind(shared_ptr<ListInstance> instance) {
-    auto environment = std::make_shared<Environment>(closure);
-    environment->define("this", Object::make_instance_obj(instance));
-    return std::make_shared<ListLenMethods>(environment, declaration);
+static StringBuilderInstance &builderOf(LoxInstance &self) {
+    return static_cast<StringBuilderInstance &>(self);
+}
+
+// returns the builder, so appends can be chained
+static Object builderAppend(Interpreter &interpreter, LoxInstance &self, Arguments args) {
+    stringify(args[0], builderOf(self).buffer);
+    return Object::make_instance_obj(self.shared_from_this());
+}
+
+static Object builderToString(Interpreter &interpreter, LoxInstance &self, Arguments args) {
+    return Object::make_obj(builderOf(self).buffer);
+}
+
+static Object builderLen(Interpreter &interpreter, LoxInstance &self, Arguments args) {
+    return Object::make_obj(double(builderOf(self).buffer.size()));
 }
+
+static Object builderClear(Interpreter &interpreter, LoxInstance &self, Arguments args) {
+    builderOf(self).buffer.clear();
+    return Object::make_nil_obj();
+}
+
+StringBuilderClass::StringBuilderClass() : LoxClass("StringBuilder", nullptr, {}) {
+    this->nativeMethods["append"] = std::make_shared<NativeMethod>("append", 1, builderAppend);
+    this->nativeMethods["toString"] = std::make_shared<NativeMethod>("toString", 0, builderToString);
+    this->nativeMethods["len"] = std::make_shared<NativeMethod>("len", 0, builderLen);
+    this->nativeMethods["clear"] = std::make_shared<NativeMethod>("clear", 0, builderClear);
+}
+
+Object StringBuilderClass::call(Interpreter &interpreter, Arguments args) {
+    return Object::make_instance_obj(std::make_shared<StringBuilderInstance>(shared_from_this()));
+}
+
+size_t StringBuilderClass::arity() { return 0; }
+
+StringBuilderInstance::StringBuilderInstance(shared_ptr<LoxClass> klass) : LoxInstance(std::move(klass)) {}
 // ------------------------------------------------------------------------------------------
-ListAppendMethods::ListAppendMethods(shared_ptr<Environment> closure_, shared_ptr<Function> declaration_)
-    : LoxFunction(declaration_, closure_, false) {}
-
-Object ListAppendMethods::call(shared_ptr<Interpreter> interpreter, std::vector<Object> args) {
-    std::get<shared_ptr<LoxList>>(
-        std::get<shared_ptr<LoxInstance>>(this->closure->getValues()["this"].data)
-            ->fields["value"]
-            .data
-    )
-        ->append(args[0]);
+static MapInstance &mapOf(LoxInstance &self) {
+    return static_cast<MapInstance &>(self);
+}
+
+// a missing key reads as nil
+static Object mapGet(Interpreter &interpreter, LoxInstance &self, Arguments args) {
+    Object *value = mapOf(self).map.find(args[0]);
+    return value != nullptr ? *value : Object::make_nil_obj();
+}
+
+static Object mapSet(Interpreter &interpreter, LoxInstance &self, Arguments args) {
+    mapOf(self).map.set(args[0], args[1]);
     return Object::make_nil_obj();
 }
 
-shared_ptr<ListAppendMethods>
-ListAppendMethods::bind(shared_ptr<ListInstance> instance) {
-    auto environment = std::make_shared<Environment>(closure);
-    environment->define("this", Object::make_instance_obj(instance));
-    return std::make_shared<ListAppendMethods>(environment, declaration);
+static Object mapHas(Interpreter &interpreter, LoxInstance &self, Arguments args) {
+    return Object::make_obj(mapOf(self).map.find(args[0]) != nullptr);
+}
+
+// returns whether the key was present
+static Object mapDelete(Interpreter &interpreter, LoxInstance &self, Arguments args) {
+    return Object::make_obj(mapOf(self).map.remove(args[0]));
+}
+
+static Object mapKeys(Interpreter &interpreter, LoxInstance &self, Arguments args) {
+    const auto &entries = mapOf(self).map.entries();
+    std::vector<Object> keys;
+    keys.reserve(entries.size());
+    for (const auto &entry: entries) {
+        keys.push_back(entry.key);
+    }
+    return Object::make_obj(std::make_shared<LoxList>(std::move(keys)));
+}
+
+static Object mapLen(Interpreter &interpreter, LoxInstance &self, Arguments args) {
+    return Object::make_obj(double(mapOf(self).map.size()));
+}
+
+MapClass::MapClass() : LoxClass("map", nullptr, {}) {
+    this->nativeMethods["get"] = std::make_shared<NativeMethod>("get", 1, mapGet);
+    this->nativeMethods["set"] = std::make_shared<NativeMethod>("set", 2, mapSet);
+    this->nativeMethods["has"] = std::make_shared<NativeMethod>("has", 1, mapHas);
+    this->nativeMethods["delete"] = std::make_shared<NativeMethod>("delete", 1, mapDelete);
+    this->nativeMethods["keys"] = std::make_shared<NativeMethod>("keys", 0, mapKeys);
+    this->nativeMethods["len"] = std::make_shared<NativeMethod>("len", 0, mapLen);
+}
+
+Object MapClass::call(Interpreter &interpreter, Arguments args) {
+    return Object::make_instance_obj(std::make_shared<MapInstance>(shared_from_this()));
+}
+
+size_t MapClass::arity() { return 0; }
+
+MapInstance::MapInstance(shared_ptr<LoxClass> klass) : LoxInstance(std::move(klass)) {}
+
+Object MapInstance::getIndex(const Object &key) {
+    Object *value = map.find(key);
+    return value != nullptr ? *value : Object::make_nil_obj();
 }
-// ------------------------------------------------------------------------------------------
\ No newline at end of file
+
+void MapInstance::setIndex(const Object &key, Object value) {
+    map.set(key, std::move(value));
+}
+// ------------------------------------------------------------------------------------------
@@ -0,0 +1,292 @@
+#include "../../include/BuiltInFile.hpp"
+#include "../../include/BuiltInIo.hpp"
+#include "../../include/LoxClass.hpp"
+#include "../../include/LoxString.hpp"
+#include "../../include/NativeFunction.hpp"
+#include "../../include/RuntimeError.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+#include <variant>
+
+// smaller files are not worth setting up and tearing down a mapping
+static constexpr size_t mapThreshold = 1024 * 1024;
+
+static int openFile(const std::string &path, int flags) {
+    int fd = ::open(path.c_str(), flags | O_CLOEXEC, 0666);
+    if (fd < 0) {
+        throw RuntimeError("Runtime Error. Could not open file '" + path + "': " + std::strerror(errno) + ".");
+    }
+    return fd;
+}
+
+const std::string &stringArgument(const Object &argument, const char *what) {
+    if (!std::holds_alternative<shared_ptr<LoxString>>(argument.data)) {
+        throw RuntimeError(string("Runtime Error. ") + what + " must be a string.");
+    }
+    return std::get<shared_ptr<LoxString>>(argument.data)->str();
+}
+
+int readDescriptor(int fd, size_t size, std::string &content) {
+    // pipes and /proc files report no size and still have contents
+    content.resize(size > 0 ? size : FileReader::bufferSize);
+    size_t offset = 0;
+    while (true) {
+        if (offset == content.size()) {
+            if (size > 0) {
+                break;// the size fstat reported, read as of the call
+            }
+            content.resize(content.size() * 2);
+        }
+        ssize_t count = ::read(fd, &content[offset], content.size() - offset);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count < 0) {
+            return errno;
+        }
+        if (count == 0) {
+            break;
+        }
+        offset += static_cast<size_t>(count);
+    }
+    content.resize(offset);
+    return 0;
+}
+
+// ------------------------------------------------------------------------------------------
+static Object readerReadLine(Interpreter &interpreter, LoxInstance &self, Arguments args) {
+    std::string line;
+    if (!static_cast<FileReader &>(self).readLine(line)) {
+        return Object::make_nil_obj();
+    }
+    return Object::make_obj(std::move(line));
+}
+
+static Object readerClose(Interpreter &interpreter, LoxInstance &self, Arguments args) {
+    static_cast<FileReader &>(self).close();
+    return Object::make_nil_obj();
+}
+
+static const shared_ptr<LoxClass> &fileReaderClass() {
+    static const auto klass = [] {
+        auto reader = std::make_shared<LoxClass>("FileReader", nullptr, map<string, shared_ptr<LoxFunction>>{});
+        reader->nativeMethods["readLine"] = std::make_shared<NativeMethod>("readLine", 0, readerReadLine);
+        // iterator protocol, next() returns nil when the lines run out
+        reader->nativeMethods["next"] = std::make_shared<NativeMethod>("next", 0, readerReadLine);
+        reader->nativeMethods["close"] = std::make_shared<NativeMethod>("close", 0, readerClose);
+        return reader;
+    }();
+    return klass;
+}
+
+FileReader::FileReader(int fd_)
+    : LoxInstance(fileReaderClass()), fd(fd_), buffer(new char[bufferSize]) {
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+}
+
+FileReader::~FileReader() {
+    close();
+}
+
+bool FileReader::readLine(std::string &line) {
+    size_t scanned = 0;// bytes after start already searched
+    while (true) {
+        auto newline = static_cast<char *>(std::memchr(buffer.get() + start + scanned, '\n', end - start - scanned));
+        if (newline != nullptr) {
+            line.assign(buffer.get() + start, newline);
+            start = static_cast<size_t>(newline - buffer.get()) + 1;
+            return true;
+        }
+        scanned = end - start;
+        if (!fill()) {
+            // the last line may not end with '\n'
+            if (start == end) {
+                return false;
+            }
+            line.assign(buffer.get() + start, end - start);
+            start = end;
+            return true;
+        }
+    }
+}
+
+/// @brief read more of the file behind the buffered bytes, false at end of file
+bool FileReader::fill() {
+    if (eof || fd < 0) {
+        return false;
+    }
+    // keep the partial line, move it to the front
+    if (start > 0) {
+        std::memmove(buffer.get(), buffer.get() + start, end - start);
+        end -= start;
+        start = 0;
+    }
+    // a line longer than the buffer, grow it
+    if (end == capacity) {
+        std::unique_ptr<char[]> grown(new char[capacity * 2]);
+        std::memcpy(grown.get(), buffer.get(), end);
+        buffer = std::move(grown);
+        capacity *= 2;
+    }
+    while (true) {
+        ssize_t count = ::read(fd, buffer.get() + end, capacity - end);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count < 0) {
+            throw RuntimeError(string("Runtime Error. Could not read file: ") + std::strerror(errno) + ".");
+        }
+        if (count == 0) {
+            eof = true;
+            return false;
+        }
+        end += static_cast<size_t>(count);
+        return true;
+    }
+}
+
+void FileReader::close() {
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+// ------------------------------------------------------------------------------------------
+static FileWriter &writerOf(LoxInstance &self) {
+    return static_cast<FileWriter &>(self);
+}
+
+static Object writerWrite(Interpreter &interpreter, LoxInstance &self, Arguments args) {
+    std::string text;
+    stringify(args[0], text);
+    writerOf(self).write(text);
+    return Object::make_nil_obj();
+}
+
+static Object writerWriteLine(Interpreter &interpreter, LoxInstance &self, Arguments args) {
+    std::string text;
+    stringify(args[0], text);
+    text += '\n';
+    writerOf(self).write(text);
+    return Object::make_nil_obj();
+}
+
+static Object writerFlush(Interpreter &interpreter, LoxInstance &self, Arguments args) {
+    writerOf(self).flush();
+    return Object::make_nil_obj();
+}
+
+static Object writerClose(Interpreter &interpreter, LoxInstance &self, Arguments args) {
+    writerOf(self).close();
+    return Object::make_nil_obj();
+}
+
+static const shared_ptr<LoxClass> &fileWriterClass() {
+    static const auto klass = [] {
+        auto writer = std::make_shared<LoxClass>("FileWriter", nullptr, map<string, shared_ptr<LoxFunction>>{});
+        writer->nativeMethods["write"] = std::make_shared<NativeMethod>("write", 1, writerWrite);
+        writer->nativeMethods["writeLine"] = std::make_shared<NativeMethod>("writeLine", 1, writerWriteLine);
+        writer->nativeMethods["flush"] = std::make_shared<NativeMethod>("flush", 0, writerFlush);
+        writer->nativeMethods["close"] = std::make_shared<NativeMethod>("close", 0, writerClose);
+        return writer;
+    }();
+    return klass;
+}
+
+FileWriter::FileWriter(int fd_)
+    : LoxInstance(fileWriterClass()), fd(fd_), output(fd_) {}
+
+FileWriter::~FileWriter() {
+    // errors cannot be raised from here, a script that cares closes the file
+    if (fd >= 0) {
+        output.flush();
+        ::close(fd);
+    }
+}
+
+void FileWriter::write(std::string_view text) {
+    if (fd < 0) {
+        throw RuntimeError("Runtime Error. Write to a closed file.");
+    }
+    output.write(text);
+    check(output.takeError());
+}
+
+void FileWriter::flush() {
+    output.flush();
+    check(output.takeError());
+}
+
+void FileWriter::close() {
+    if (fd >= 0) {
+        output.flush();
+        int error = output.takeError();
+        if (::close(fd) != 0 && error == 0) {
+            error = errno;
+        }
+        fd = -1;
+        check(error);
+    }
+}
+
+/// @brief a buffered write that failed is raised by the next call that flushes
+void FileWriter::check(int error) {
+    if (error != 0) {
+        throw RuntimeError(string("Runtime Error. Could not write file: ") + std::strerror(error) + ".");
+    }
+}
+
+// ------------------------------------------------------------------------------------------
+Object nativeOpen(Interpreter &interpreter, Arguments args) {
+    const auto &path = stringArgument(args[0], "File path");
+    const auto &mode = stringArgument(args[1], "File mode");
+    if (mode == "r") {
+        return Object::make_instance_obj(std::make_shared<FileReader>(openFile(path, O_RDONLY)));
+    }
+    if (mode == "w") {
+        return Object::make_instance_obj(std::make_shared<FileWriter>(openFile(path, O_WRONLY | O_CREAT | O_TRUNC)));
+    }
+    if (mode == "a") {
+        return Object::make_instance_obj(std::make_shared<FileWriter>(openFile(path, O_WRONLY | O_CREAT | O_APPEND)));
+    }
+    throw RuntimeError("Runtime Error. File mode must be \"r\", \"w\" or \"a\".");
+}
+
+Object nativeReadLines(Interpreter &interpreter, Arguments args) {
+    const auto &path = stringArgument(args[0], "File path");
+    return Object::make_instance_obj(std::make_shared<FileReader>(openFile(path, O_RDONLY)));
+}
+
+/// @brief the whole file as a string. Lox strings own their bytes, so one
+/// copy out of the page cache is the least this can do: large regular files
+/// are mapped and copied from the mapping, anything else is read(2) into a
+/// string sized from fstat.
+Object nativeReadAll(Interpreter &interpreter, Arguments args) {
+    const auto &path = stringArgument(args[0], "File path");
+    int fd = openFile(path, O_RDONLY);
+    struct stat info {};
+    size_t size = ::fstat(fd, &info) == 0 && info.st_size > 0 ? static_cast<size_t>(info.st_size) : 0;
+    if (S_ISREG(info.st_mode) && size >= mapThreshold) {
+        void *mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+        if (mapped != MAP_FAILED) {
+            ::madvise(mapped, size, MADV_SEQUENTIAL);
+            std::string content(static_cast<const char *>(mapped), size);
+            ::munmap(mapped, size);
+            ::close(fd);
+            return Object::make_obj(std::move(content));
+        }
+    }
+    std::string content;
+    int error = readDescriptor(fd, size, content);
+    ::close(fd);
+    if (error != 0) {
+        throw RuntimeError("Runtime Error. Could not read file '" + path + "': " + std::strerror(error) + ".");
+    }
+    return Object::make_obj(std::move(content));
+}
@@ -4,10 +4,7 @@
 #include "../../include/LoxList.hpp"
 
 // Native clock
-size_t ClockCallable::arity() { return 0; }
-
-Object ClockCallable::call(shared_ptr<Interpreter> interpreter,
-                           std::vector<Object> args) {
+Object nativeClock(Interpreter &interpreter, Arguments args) {
   static_assert(std::is_integral_v<std::chrono::system_clock::rep>,
                 "Representation of ticks isn't an integral value.");
 
@@ -18,16 +15,7 @@ Object ClockCallable::call(shared_ptr<Interpreter> interpreter,
       1000.0));
 }
 
-std::string ClockCallable::toString() { return "<native fn: clock>"; }
-
 // native type
-size_t TypeCallable::arity() { return aritys; }
-
-Object TypeCallable::call(shared_ptr<Interpreter> interpreter,
-                          std::vector<Object> args) {
-  if (args.size() != 1)
-    throw std::runtime_error("Type function takes exactly one argument.");
+Object nativeType(Interpreter &interpreter, Arguments args) {
   return Object::make_obj(args[0].toString());
 }
-
-std::string TypeCallable::toString() { return "<native fn: type>"; }
@@ -1,88 +1,98 @@
 #include "../../include/BuiltInIo.hpp"
-#include "../../include/BuiltInFun.hpp"
+#include "../../include/Interpreter.hpp"
 #include "../../include/LoxClass.hpp"
 #include "../../include/LoxInstance.hpp"
 #include "../../include/LoxList.hpp"
+#include "../../include/LoxString.hpp"
+#include "../../include/NumberFormat.hpp"
+#include "../../include/OutputBuffer.hpp"
 #include <memory>
 #include <utility>
 #include <variant>
 using std::cin;
 
 // Native print
-size_t PrintCallable::arity() { return aritys; }
-
-Object PrintCallable::call(shared_ptr<Interpreter> interpreter, std::vector<Object> args) {
-    std::stringstream stream;
+Object nativePrint(Interpreter &interpreter, Arguments args) {
+    // reused between calls so printing does not allocate once it has grown
+    thread_local std::string line;
+    line.clear();
     for (const auto &arg: args) {
-        stream << stringify(arg, stream) << ' ';
+        stringify(arg, line);
+        line += ' ';
     }
-    std::cout << stream.str() << '\n';
+    interpreter.context.output.writeLine(line);
     return Object::make_nil_obj();
 }
 
-std::string PrintCallable::toString() { return "<native fn: print>"; }
-
 // Native input
-size_t InputCallable::arity() { return aritys; }
-
-Object InputCallable::call(shared_ptr<Interpreter> interpreter, vector<Object> args) {
-    std::cout << "Enter input: ";
-    std::stringstream instream;
+Object nativeInput(Interpreter &interpreter, Arguments args) {
+    auto &output = interpreter.context.output;
+    output.write("Enter input: ");
+    // everything printed so far has to be visible before blocking on stdin
+    output.flush();
     std::string input;
     getline(cin, input);
 
     return Object::make_obj(input);
 }
 
-string InputCallable::toString() { return "<native fn: input>"; }
+// Native flush
+Object nativeFlush(Interpreter &interpreter, Arguments args) {
+    interpreter.context.output.flush();
+    return Object::make_nil_obj();
+}
 
 // Native print
-std::string stringify(const Object &item, std::stringstream &stream) {
+void stringify(const Object &item, std::string &out) {
     // item.type == Object::Object_type::Object_bool
-    if (std::holds_alternative<bool>(item.data))
-        return std::get<bool>(item.data) ? "true" : "false";
-
+    if (std::holds_alternative<bool>(item.data)) {
+        out += std::get<bool>(item.data) ? "true" : "false";
+        return;
+    }
     // if (item.type == Object::Object_type::Object_str)
-    if (std::holds_alternative<std::string>(item.data)) {
-        return std::get<std::string>(item.data);
+    if (std::holds_alternative<shared_ptr<LoxString>>(item.data)) {
+        out += std::get<shared_ptr<LoxString>>(item.data)->str();
+        return;
     }
     // item.type == Object::Object_type::Object_num
     if (std::holds_alternative<double>(item.data)) {
-        double num = std::get<double>(item.data);
-        auto num_as_string = std::to_string(std::move(num));
-        num_as_string.erase(num_as_string.find_last_not_of('0') + 1, std::string::npos);
-        num_as_string.erase(num_as_string.find_last_not_of('.') + 1, std::string::npos);
-        return num_as_string;
+        appendNumber(out, std::get<double>(item.data));
+        return;
     }
     // integel
     if (std::holds_alternative<int>(item.data)) {
-        int i32num = std::get<int>(item.data);
-        auto i32num_as_string = std::to_string(std::move(i32num));
-        return i32num_as_string;
+        appendNumber(out, std::get<int>(item.data));
+        return;
     }
     // item.type == Object::Object_type::Object_fun
-    if (item.data.index() == 5)
-        return std::get<shared_ptr<LoxCallable>>(item.data)->toString();
+    if (item.data.index() == 5) {
+        out += std::get<shared_ptr<LoxCallable>>(item.data)->toString();
+        return;
+    }
     // item.type == Object::Object_type::Object_class
-    if (item.data.index() == 7)
-        return std::get<shared_ptr<LoxClass>>(item.data)->toString();
+    if (item.data.index() == 7) {
+        out += std::get<shared_ptr<LoxClass>>(item.data)->toString();
+        return;
+    }
     // item.type == Object::Object_type::Object_instance
     if (item.data.index() == 6) {
-        return std::get<shared_ptr<LoxInstance>>(item.data)->toString();
+        out += std::get<shared_ptr<LoxInstance>>(item.data)->toString();
+        return;
     }
     // item.type == Object::Object_type::Object_list
     if (std::holds_alternative<shared_ptr<LoxList>>(item.data)) {
         auto items = std::get<shared_ptr<LoxList>>(item.data);
-        stream << "[";
+        out += '[';
         auto len = items->length();
         for (size_t i = 0u; i < len; ++i) {
-            stream << stringify(items->at(static_cast<int>(i)), stream);
-            stream << ",";
+            if (i > 0) {
+                out += ',';
+            }
+            stringify(items->get(static_cast<int>(i)), out);
         }
-        stream.seekp(-1, std::ios_base::end);
-        stream << "]";
-        return {};
+        out += ']';
+        return;
     }
 
-    return "nil";
+    out += "nil";
 }
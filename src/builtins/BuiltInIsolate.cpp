@@ -0,0 +1,185 @@
+#include "../../include/BuiltInIsolate.hpp"
+#include "../../include/BuiltInAsync.hpp"
+#include "../../include/Interpreter.hpp"
+#include "../../include/LoxClass.hpp"
+#include "../../include/LoxFunction.hpp"
+#include "../../include/LoxList.hpp"
+#include "../../include/NativeFunction.hpp"
+#include "../../include/RuntimeError.hpp"
+#include <utility>
+#include <variant>
+#include <vector>
+
+static Object channelSend(Interpreter &interpreter, LoxInstance &self, Arguments args) {
+    static_cast<Channel &>(self).send(packValue(args[0]));
+    return Object::make_nil_obj();
+}
+
+static Object channelReceive(Interpreter &interpreter, LoxInstance &self, Arguments args) {
+    PackedValue value;
+    if (!static_cast<Channel &>(self).receive(value)) {
+        return Object::make_nil_obj();
+    }
+    return unpackValue(interpreter, value);
+}
+
+static Object channelClose(Interpreter &interpreter, LoxInstance &self, Arguments args) {
+    static_cast<Channel &>(self).close();
+    return Object::make_nil_obj();
+}
+
+static const shared_ptr<LoxClass> &channelClass() {
+    static const auto klass = [] {
+        auto channel = std::make_shared<LoxClass>("Channel", nullptr, map<string, shared_ptr<LoxFunction>>{});
+        channel->nativeMethods["send"] = std::make_shared<NativeMethod>("send", 1, channelSend);
+        channel->nativeMethods["receive"] = std::make_shared<NativeMethod>("receive", 0, channelReceive);
+        channel->nativeMethods["close"] = std::make_shared<NativeMethod>("close", 0, channelClose);
+        return channel;
+    }();
+    return klass;
+}
+
+Channel::Channel() : LoxInstance(channelClass()) {}
+
+void Channel::send(PackedValue value) {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (closed) {
+            throw RuntimeError("Runtime Error. Send on a closed channel.");
+        }
+        queue.push_back(std::move(value));
+    }
+    ready.notify_one();
+}
+
+bool Channel::receive(PackedValue &value) {
+    std::unique_lock<std::mutex> guard(lock);
+    ready.wait(guard, [this] { return !queue.empty() || closed; });
+    if (queue.empty()) {
+        return false;
+    }
+    value = std::move(queue.front());
+    queue.pop_front();
+    return true;
+}
+
+void Channel::close() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        closed = true;
+    }
+    ready.notify_all();
+}
+
+// ------------------------------------------------------------------------------------------
+static Object isolateJoin(Interpreter &interpreter, LoxInstance &self, Arguments args) {
+    auto &isolate = static_cast<Isolate &>(self);
+    isolate.join();
+    if (isolate.result().failed) {
+        throw RuntimeError(isolate.result().error);
+    }
+    return unpackValue(interpreter, isolate.result().result);
+}
+
+static const shared_ptr<LoxClass> &isolateClass() {
+    static const auto klass = [] {
+        auto isolate = std::make_shared<LoxClass>("Isolate", nullptr, map<string, shared_ptr<LoxFunction>>{});
+        isolate->nativeMethods["join"] = std::make_shared<NativeMethod>("join", 0, isolateJoin);
+        return isolate;
+    }();
+    return klass;
+}
+
+Isolate::Isolate(shared_ptr<Interpreter> interpreter, shared_ptr<LoxCallable> function, PackedValue arguments,
+                 shared_ptr<State> state_)
+    : LoxInstance(isolateClass()), state(std::move(state_)) {
+    thread = std::thread([interpreter = std::move(interpreter), function = std::move(function),
+                          arguments = std::move(arguments), state = state]() mutable {
+        try {
+            Object unpacked = unpackValue(*interpreter, arguments);
+            std::vector<Object> values = std::get<shared_ptr<LoxList>>(unpacked.data)->take();
+            Object result = function->call(*interpreter, Arguments(values));
+            if (interpreter->events != nullptr) {
+                interpreter->events->run();
+            }
+            state->result = packValue(result);
+        } catch (const RuntimeError &error) {
+            state->failed = true;
+            state->error = isolateError(error);
+        } catch (const std::exception &error) {
+            state->failed = true;
+            state->error = string("Runtime Error. Spawned function crashed: ") + error.what();
+        }
+        // the interpreter refers to the context in state, let it go first
+        function.reset();
+        interpreter.reset();
+    });
+}
+
+Isolate::~Isolate() {
+    join();
+}
+
+void Isolate::join() {
+    std::lock_guard<std::mutex> guard(lock);
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+// ------------------------------------------------------------------------------------------
+shared_ptr<LoxFunction> topLevelFunction(Interpreter &interpreter, const Object &value, const string &native) {
+    shared_ptr<LoxFunction> function;
+    if (value.data.index() == 5) {
+        function = std::dynamic_pointer_cast<LoxFunction>(std::get<shared_ptr<LoxCallable>>(value.data));
+    }
+    // globals follows the scope being executed, the program's globals are its root
+    Environment *root = interpreter.globals.get();
+    while (root->enclosing != nullptr) {
+        root = root->enclosing.get();
+    }
+    if (function == nullptr || function->isInitializer || function->closure.get() != root) {
+        throw RuntimeError("Runtime Error. " + native + " expects a function declared at the top level.");
+    }
+    return function;
+}
+
+shared_ptr<LoxCallable> functionIn(Interpreter &isolate, const LoxFunction &function) {
+    const string &name = function.declaration->functionName.lexeme;
+    Object value = isolate.globals->get(Token(IDENTIFIER, name, Object::make_nil_obj(), -1));
+    // a class declared later under the same name replaces the function there
+    if (value.data.index() != 5) {
+        throw RuntimeError("Runtime Error. '" + name + "' does not name a function in the isolate.");
+    }
+    return std::get<shared_ptr<LoxCallable>>(value.data);
+}
+
+string isolateError(const RuntimeError &error) {
+    if (error.token.line == -1) {
+        return error.message;
+    }
+    return "[Line " + std::to_string(error.token.line) + "] " + error.message;
+}
+
+Object nativeSpawn(Interpreter &interpreter, Arguments args) {
+    if (args.empty()) {
+        throw RuntimeError("Runtime Error. spawn expects a function declared at the top level.");
+    }
+    auto function = topLevelFunction(interpreter, args[0], "spawn");
+    if (args.size() - 1 != function->arity()) {
+        throw RuntimeError("Runtime Error. Expected " + std::to_string(function->arity()) + " arguments but got " +
+                           std::to_string(args.size() - 1) + ".");
+    }
+    auto arguments = std::make_shared<LoxList>(std::vector<Object>(args.begin() + 1, args.end()));
+    PackedValue packed = packValue(Object::make_obj(arguments));
+
+    auto state = std::make_shared<Isolate::State>(interpreter.context.output);
+    auto isolate = interpreter.isolate(state->context);
+    auto target = functionIn(*isolate, *function);
+    return Object::make_instance_obj(
+        std::make_shared<Isolate>(isolate, std::move(target), std::move(packed), std::move(state)));
+}
+
+Object nativeChannel(Interpreter &interpreter, Arguments args) {
+    return Object::make_instance_obj(std::make_shared<Channel>());
+}
@@ -0,0 +1,596 @@
+#include "../../include/BuiltInJson.hpp"
+#include "../../include/BuiltInClass.hpp"
+#include "../../include/BuiltInIo.hpp"
+#include "../../include/Interpreter.hpp"
+#include "../../include/LoxInstance.hpp"
+#include "../../include/LoxList.hpp"
+#include "../../include/LoxString.hpp"
+#include "../../include/NumberFormat.hpp"
+#include "../../include/RuntimeError.hpp"
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <typeinfo>
+#include <utility>
+#include <variant>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+    // nesting deeper than this is rejected instead of overflowing the stack
+    constexpr int maxDepth = 5000;
+
+    struct BlockMasks {
+        uint64_t quote;
+        uint64_t backslash;
+        uint64_t op;// { } [ ] : ,
+    };
+
+    /// @brief classify the 64 bytes of a block, bit i stands for block[i]
+    BlockMasks classify(const char *block) {
+        BlockMasks masks{0, 0, 0};
+#if defined(__SSE2__)
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i backslash = _mm_set1_epi8('\\');
+        const __m128i ops[] = {_mm_set1_epi8('{'), _mm_set1_epi8('}'), _mm_set1_epi8('['),
+                               _mm_set1_epi8(']'), _mm_set1_epi8(':'), _mm_set1_epi8(',')};
+        for (int i = 0; i < 4; i++) {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + i * 16));
+            __m128i op = _mm_cmpeq_epi8(chunk, ops[0]);
+            for (int k = 1; k < 6; k++) {
+                op = _mm_or_si128(op, _mm_cmpeq_epi8(chunk, ops[k]));
+            }
+            int shift = i * 16;
+            masks.quote |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, quote)))) << shift;
+            masks.backslash |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, backslash)))) << shift;
+            masks.op |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(op))) << shift;
+        }
+#else
+        for (int i = 0; i < 64; i++) {
+            uint64_t bit = uint64_t{1} << i;
+            switch (block[i]) {
+                case '"':
+                    masks.quote |= bit;
+                    break;
+                case '\\':
+                    masks.backslash |= bit;
+                    break;
+                case '{':
+                case '}':
+                case '[':
+                case ']':
+                case ':':
+                case ',':
+                    masks.op |= bit;
+                    break;
+                default:
+                    break;
+            }
+        }
+#endif
+        return masks;
+    }
+
+    /// @brief the characters escaped by a backslash, carry says whether the
+    /// first character of the block is escaped by the previous block
+    uint64_t escapedChars(uint64_t backslashes, bool &carry) {
+        uint64_t escaped = carry ? 1 : 0;
+        carry = false;
+        // a backslash that is itself escaped escapes nothing
+        uint64_t pending = backslashes & ~escaped;
+        while (pending != 0) {
+            int i = __builtin_ctzll(pending);
+            if (i == 63) {
+                carry = true;
+            } else {
+                escaped |= uint64_t{1} << (i + 1);
+                pending &= ~(uint64_t{1} << (i + 1));
+            }
+            pending &= pending - 1;
+        }
+        return escaped;
+    }
+
+    /// @brief bit i is the xor of bits 0..i, set inside strings
+    uint64_t prefixXor(uint64_t bits) {
+        bits ^= bits << 1;
+        bits ^= bits << 2;
+        bits ^= bits << 4;
+        bits ^= bits << 8;
+        bits ^= bits << 16;
+        bits ^= bits << 32;
+        return bits;
+    }
+
+    bool isWhitespace(char c) {
+        return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+    }
+
+    void appendUtf8(std::string &out, uint32_t code) {
+        if (code < 0x80) {
+            out += static_cast<char>(code);
+        } else if (code < 0x800) {
+            out += static_cast<char>(0xC0 | (code >> 6));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+            out += static_cast<char>(0xE0 | (code >> 12));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (code >> 18));
+            out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+
+    // the second pass, walks the structural index and builds the values
+    class JsonParser {
+    public:
+        JsonParser(Interpreter &interpreter_, std::string_view text_, const std::vector<uint32_t> &index_)
+            : interpreter(interpreter_), text(text_), index(index_) {}
+
+        Object parseDocument() {
+            Object result = value(0);
+            skipWhitespace();
+            if (pos != text.size()) {
+                error("unexpected text after the value");
+            }
+            return result;
+        }
+
+    private:
+        Interpreter &interpreter;
+        std::string_view text;
+        const std::vector<uint32_t> &index;
+        size_t pos = 0; // next unread character
+        size_t next = 0;// next unread entry of the index
+
+        [[noreturn]] void error(const char *what) const {
+            throw RuntimeError("Runtime Error. Invalid JSON at offset " + std::to_string(pos) + ", " + what + ".");
+        }
+
+        void skipWhitespace() {
+            while (pos < text.size() && isWhitespace(text[pos])) {
+                pos++;
+            }
+        }
+
+        /// @brief consume the structural character at pos, it must be in the index
+        char structural() {
+            skipWhitespace();
+            if (next >= index.size() || index[next] != pos) {
+                error(pos < text.size() ? "unexpected character" : "unexpected end of input");
+            }
+            next++;
+            return text[pos++];
+        }
+
+        Object value(int depth) {
+            if (depth > maxDepth) {
+                error("nested too deeply");
+            }
+            skipWhitespace();
+            if (pos >= text.size()) {
+                error("unexpected end of input");
+            }
+            switch (text[pos]) {
+                case '[':
+                    structural();
+                    return array(depth);
+                case '{':
+                    structural();
+                    return object(depth);
+                case '"':
+                    structural();
+                    return Object::make_obj(parseString());
+                default:
+                    return scalar();
+            }
+        }
+
+        Object array(int depth) {
+            std::vector<Object> values;
+            skipWhitespace();
+            if (pos < text.size() && text[pos] == ']') {
+                structural();
+                return Object::make_obj(std::make_shared<LoxList>());
+            }
+            while (true) {
+                values.push_back(value(depth + 1));
+                char c = structural();
+                if (c == ']') {
+                    break;
+                }
+                if (c != ',') {
+                    pos--;
+                    error("expected ',' or ']'");
+                }
+            }
+            return Object::make_obj(std::make_shared<LoxList>(std::move(values)));
+        }
+
+        Object object(int depth) {
+            auto map = std::make_shared<MapInstance>(interpreter.mapClass);
+            skipWhitespace();
+            if (pos < text.size() && text[pos] == '}') {
+                structural();
+                return Object::make_instance_obj(map);
+            }
+            while (true) {
+                skipWhitespace();
+                if (pos >= text.size() || text[pos] != '"') {
+                    error("expected a string key");
+                }
+                structural();
+                Object key = Object::make_obj(parseString());
+                if (structural() != ':') {
+                    pos--;
+                    error("expected ':'");
+                }
+                map->map.set(key, value(depth + 1));
+                char c = structural();
+                if (c == '}') {
+                    break;
+                }
+                if (c != ',') {
+                    pos--;
+                    error("expected ',' or '}'");
+                }
+            }
+            return Object::make_instance_obj(map);
+        }
+
+        /// @brief the string after an opening quote, the closing quote is
+        /// the next index entry
+        std::string parseString() {
+            if (next >= index.size() || text[index[next]] != '"') {
+                error("unterminated string");
+            }
+            size_t close = index[next++];
+            std::string_view raw = text.substr(pos, close - pos);
+            pos = close + 1;
+            if (std::memchr(raw.data(), '\\', raw.size()) == nullptr) {
+                return std::string(raw);
+            }
+            std::string out;
+            out.reserve(raw.size());
+            for (size_t i = 0; i < raw.size(); i++) {
+                if (raw[i] != '\\') {
+                    out += raw[i];
+                    continue;
+                }
+                if (++i >= raw.size()) {
+                    error("bad escape");
+                }
+                switch (raw[i]) {
+                    case '"': out += '"'; break;
+                    case '\\': out += '\\'; break;
+                    case '/': out += '/'; break;
+                    case 'b': out += '\b'; break;
+                    case 'f': out += '\f'; break;
+                    case 'n': out += '\n'; break;
+                    case 'r': out += '\r'; break;
+                    case 't': out += '\t'; break;
+                    case 'u': {
+                        uint32_t code = hex4(raw, i + 1);
+                        i += 4;
+                        // a surrogate pair encodes one code point above U+FFFF
+                        if (code >= 0xD800 && code < 0xDC00 && i + 2 < raw.size() && raw[i + 1] == '\\' && raw[i + 2] == 'u') {
+                            uint32_t low = hex4(raw, i + 3);
+                            if (low >= 0xDC00 && low < 0xE000) {
+                                code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                                i += 6;
+                            }
+                        }
+                        appendUtf8(out, code);
+                        break;
+                    }
+                    default:
+                        error("bad escape");
+                }
+            }
+            return out;
+        }
+
+        uint32_t hex4(std::string_view raw, size_t at) {
+            if (at + 4 > raw.size()) {
+                error("bad \\u escape");
+            }
+            uint32_t code = 0;
+            auto result = std::from_chars(raw.data() + at, raw.data() + at + 4, code, 16);
+            if (result.ptr != raw.data() + at + 4) {
+                error("bad \\u escape");
+            }
+            return code;
+        }
+
+        bool literal(std::string_view word) {
+            if (text.substr(pos, word.size()) != word) {
+                return false;
+            }
+            pos += word.size();
+            return true;
+        }
+
+        static bool isDigit(char c) {
+            return c >= '0' && c <= '9';
+        }
+
+        /// @brief skip a run of digits from end, false if there is none
+        bool digits(size_t &end) const {
+            size_t start = end;
+            while (end < text.size() && isDigit(text[end])) {
+                end++;
+            }
+            return end > start;
+        }
+
+        Object scalar() {
+            if (literal("true")) {
+                return Object::make_obj(true);
+            }
+            if (literal("false")) {
+                return Object::make_obj(false);
+            }
+            if (literal("null")) {
+                return Object::make_nil_obj();
+            }
+            char c = text[pos];
+            if (c != '-' && (c < '0' || c > '9')) {
+                error("expected a value");
+            }
+            // -? (0 | [1-9][0-9]*) (. [0-9]+)? ([eE] [+-]? [0-9]+)?
+            size_t end = pos;
+            if (text[end] == '-') {
+                end++;
+            }
+            if (end < text.size() && text[end] == '0') {
+                end++;
+                if (end < text.size() && isDigit(text[end])) {
+                    error("leading zero in a number");
+                }
+            } else if (!digits(end)) {
+                error("bad number");
+            }
+            bool integral = true;
+            if (end < text.size() && text[end] == '.') {
+                integral = false;
+                end++;
+                if (!digits(end)) {
+                    error("expected digits after '.'");
+                }
+            }
+            if (end < text.size() && (text[end] == 'e' || text[end] == 'E')) {
+                integral = false;
+                end++;
+                if (end < text.size() && (text[end] == '+' || text[end] == '-')) {
+                    end++;
+                }
+                if (!digits(end)) {
+                    error("expected digits in the exponent");
+                }
+            }
+            const char *first = text.data() + pos;
+            const char *last = text.data() + end;
+            if (integral) {
+                int64_t number = 0;
+                auto result = std::from_chars(first, last, number);
+                if (result.ec == std::errc() && number >= std::numeric_limits<int>::min() &&
+                    number <= std::numeric_limits<int>::max()) {
+                    pos = end;
+                    return Object::make_obj(static_cast<int>(number));
+                }
+            }
+            double number = 0;
+            auto result = std::from_chars(first, last, number);
+            if (result.ec == std::errc::result_out_of_range) {
+                // from_chars leaves number alone, strtod tells overflow from underflow
+                number = std::strtod(std::string(first, last).c_str(), nullptr);
+                if (std::isinf(number)) {
+                    error("number out of range");
+                }
+            }
+            pos = end;
+            return Object::make_obj(number);
+        }
+    };
+
+    // ------------------------------------------------------------------------------------------
+    /// @brief append text as a JSON string, clean runs are copied in bulk
+    void writeString(std::string &out, std::string_view text) {
+        out += '"';
+        size_t i = 0;
+        size_t run = 0;// start of the run not yet copied
+        while (i < text.size()) {
+#if defined(__SSE2__)
+            // skip 16 characters at a time while none needs escaping
+            while (i + 16 <= text.size()) {
+                __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text.data() + i));
+                __m128i special = _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('"')),
+                                               _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\')));
+                // unsigned c < 0x20
+                special = _mm_or_si128(special, _mm_cmpeq_epi8(_mm_min_epu8(chunk, _mm_set1_epi8(0x1F)), chunk));
+                int mask = _mm_movemask_epi8(special);
+                if (mask != 0) {
+                    i += static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+                    break;
+                }
+                i += 16;
+            }
+            if (i >= text.size()) {
+                break;
+            }
+#endif
+            auto c = static_cast<unsigned char>(text[i]);
+            if (c != '"' && c != '\\' && c >= 0x20) {
+                i++;
+                continue;
+            }
+            out.append(text.data() + run, i - run);
+            switch (c) {
+                case '"': out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\t': out += "\\t"; break;
+                case '\b': out += "\\b"; break;
+                case '\f': out += "\\f"; break;
+                default: {
+                    static const char digits[] = "0123456789abcdef";
+                    out += "\\u00";
+                    out += digits[c >> 4];
+                    out += digits[c & 0xF];
+                }
+            }
+            run = ++i;
+        }
+        out.append(text.data() + run, text.size() - run);
+        out += '"';
+    }
+
+    void writeJson(const Object &value, std::string &out, int depth);
+
+    void writeList(const LoxList &list, std::string &out, int depth) {
+        out += '[';
+        bool first = true;
+        for (const Object &element: list) {
+            if (!first) {
+                out += ',';
+            }
+            first = false;
+            writeJson(element, out, depth + 1);
+        }
+        out += ']';
+    }
+
+    void writeInstance(LoxInstance &instance, std::string &out, int depth) {
+        if (auto list = dynamic_cast<ListInstance *>(&instance)) {
+            writeList(list->list(), out, depth);
+            return;
+        }
+        out += '{';
+        bool first = true;
+        if (auto map = dynamic_cast<MapInstance *>(&instance)) {
+            for (const auto &entry: map->map.entries()) {
+                if (!first) {
+                    out += ',';
+                }
+                first = false;
+                // JSON keys are strings, numbers and booleans are written as text
+                if (std::holds_alternative<shared_ptr<LoxString>>(entry.key.data)) {
+                    writeString(out, std::get<shared_ptr<LoxString>>(entry.key.data)->str());
+                } else {
+                    std::string key;
+                    stringify(entry.key, key);
+                    writeString(out, key);
+                }
+                out += ':';
+                writeJson(entry.value, out, depth + 1);
+            }
+        } else if (typeid(instance) == typeid(LoxInstance)) {
+            for (const auto &[name, field]: instance.fields) {
+                if (!first) {
+                    out += ',';
+                }
+                first = false;
+                writeString(out, name);
+                out += ':';
+                writeJson(field, out, depth + 1);
+            }
+        } else {
+            throw RuntimeError("Runtime Error. " + instance.toString() + " can not be converted to JSON.");
+        }
+        out += '}';
+    }
+
+    void writeJson(const Object &value, std::string &out, int depth) {
+        if (depth > maxDepth) {
+            throw RuntimeError("Runtime Error. Value is nested too deeply for JSON, is it cyclic?");
+        }
+        switch (value.data.index()) {
+            case 0:
+                writeString(out, std::get<shared_ptr<LoxString>>(value.data)->str());
+                return;
+            case 1: {
+                double number = std::get<double>(value.data);
+                if (!std::isfinite(number)) {
+                    throw RuntimeError("Runtime Error. JSON can not represent nan or infinity.");
+                }
+                appendNumber(out, number);
+                return;
+            }
+            case 2:
+                out += std::get<bool>(value.data) ? "true" : "false";
+                return;
+            case 3:
+                out += "null";
+                return;
+            case 4:
+                writeList(*std::get<shared_ptr<LoxList>>(value.data), out, depth);
+                return;
+            case 6:
+                writeInstance(*std::get<shared_ptr<LoxInstance>>(value.data), out, depth);
+                return;
+            case 8:
+                appendNumber(out, std::get<int>(value.data));
+                return;
+            default:
+                throw RuntimeError("Runtime Error. " + const_cast<Object &>(value).toString() + " can not be converted to JSON.");
+        }
+    }
+}
+
+bool jsonStructuralIndex(std::string_view text, std::vector<uint32_t> &index) {
+    index.clear();
+    index.reserve(text.size() / 8);
+    bool escapeCarry = false;
+    uint64_t inStringCarry = 0;// all ones when the previous block ended inside a string
+    char padded[64];
+    for (size_t offset = 0; offset < text.size(); offset += 64) {
+        const char *block = text.data() + offset;
+        if (text.size() - offset < 64) {
+            std::memset(padded, ' ', sizeof(padded));
+            std::memcpy(padded, block, text.size() - offset);
+            block = padded;
+        }
+        BlockMasks masks = classify(block);
+        uint64_t quotes = masks.quote & ~escapedChars(masks.backslash, escapeCarry);
+        // set from an opening quote up to, not including, its closing quote
+        uint64_t inString = prefixXor(quotes) ^ inStringCarry;
+        inStringCarry = static_cast<uint64_t>(static_cast<int64_t>(inString) >> 63);
+        uint64_t structurals = (masks.op & ~inString) | quotes;
+        while (structurals != 0) {
+            index.push_back(static_cast<uint32_t>(offset + static_cast<size_t>(__builtin_ctzll(structurals))));
+            structurals &= structurals - 1;
+        }
+    }
+    return inStringCarry == 0;
+}
+
+Object nativeJsonParse(Interpreter &interpreter, Arguments args) {
+    if (!std::holds_alternative<shared_ptr<LoxString>>(args[0].data)) {
+        throw RuntimeError("Runtime Error. jsonParse expects a string.");
+    }
+    // keeps the text alive while it is parsed
+    auto text = std::get<shared_ptr<LoxString>>(args[0].data);
+    if (text->length() > std::numeric_limits<uint32_t>::max()) {
+        throw RuntimeError("Runtime Error. JSON text is larger than 4 GiB.");
+    }
+    std::vector<uint32_t> index;
+    if (!jsonStructuralIndex(text->str(), index)) {
+        throw RuntimeError("Runtime Error. Invalid JSON, unterminated string.");
+    }
+    return JsonParser(interpreter, text->str(), index).parseDocument();
+}
+
+Object nativeJsonStringify(Interpreter &interpreter, Arguments args) {
+    std::string out;
+    writeJson(args[0], out, 0);
+    return Object::make_obj(std::move(out));
+}
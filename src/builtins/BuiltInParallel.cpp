@@ -0,0 +1,126 @@
+#include "../../include/BuiltInParallel.hpp"
+#include "../../include/BuiltInAsync.hpp"
+#include "../../include/BuiltInClass.hpp"
+#include "../../include/BuiltInIsolate.hpp"
+#include "../../include/BuiltInSerialize.hpp"
+#include "../../include/Interpreter.hpp"
+#include "../../include/LoxFunction.hpp"
+#include "../../include/LoxList.hpp"
+#include "../../include/RuntimeError.hpp"
+#include "../../include/WorkPool.hpp"
+#include <cmath>
+#include <memory>
+#include <sstream>
+#include <variant>
+#include <vector>
+
+namespace {
+    // one participant of a loop: an isolate and fn inside it
+    struct Worker {
+        explicit Worker(OutputBuffer &output) : context(output, diagnostics) {}
+
+        std::ostringstream diagnostics;
+        RunContext context;
+        shared_ptr<Interpreter> interpreter;
+        shared_ptr<LoxCallable> function;
+    };
+
+    /// @brief each(worker, i) for every i in [0, count) on the pool, in the
+    /// isolate of the participant that runs i
+    template<typename Each>
+    void inIsolates(Interpreter &interpreter, const LoxFunction &function, size_t count, Each each) {
+        auto &pool = WorkPool::shared();
+        std::vector<std::unique_ptr<Worker>> workers(pool.participants());
+        pool.parallelFor(count, [&](size_t participant, size_t begin, size_t end) {
+            auto &worker = workers[participant];
+            try {
+                if (worker == nullptr) {
+                    worker = std::make_unique<Worker>(interpreter.context.output);
+                    worker->interpreter = interpreter.isolate(worker->context);
+                    worker->function = functionIn(*worker->interpreter, function);
+                }
+                for (size_t i = begin; i < end; i++) {
+                    each(*worker, i);
+                    // what the call started finishes before it counts as done,
+                    // nothing runs the isolate's loop once the native returns
+                    if (worker->interpreter->events != nullptr) {
+                        worker->interpreter->events->run();
+                    }
+                }
+            } catch (const RuntimeError &error) {
+                throw RuntimeError(isolateError(error));
+            }
+        });
+    }
+
+    shared_ptr<LoxFunction> callback(Interpreter &interpreter, const Object &value, const string &native, size_t arity) {
+        auto function = topLevelFunction(interpreter, value, native);
+        if (function->arity() != arity) {
+            throw RuntimeError("Runtime Error. " + native + " expects a function of " + std::to_string(arity) +
+                               " argument" + (arity == 1 ? "." : "s."));
+        }
+        return function;
+    }
+
+    int boundOf(const Object &value) {
+        if (std::holds_alternative<int>(value.data)) {
+            return std::get<int>(value.data);
+        }
+        if (std::holds_alternative<double>(value.data)) {
+            double number = std::get<double>(value.data);
+            if (number == std::floor(number) && std::abs(number) <= 2147483647.0) {
+                return static_cast<int>(number);
+            }
+        }
+        throw RuntimeError("Runtime Error. parallelFor bounds must be integers.");
+    }
+}
+
+Object nativeParallelMap(Interpreter &interpreter, Arguments args) {
+    const LoxList *list = nullptr;
+    bool instance = false;
+    if (std::holds_alternative<shared_ptr<LoxList>>(args[0].data)) {
+        list = std::get<shared_ptr<LoxList>>(args[0].data).get();
+    } else if (std::holds_alternative<shared_ptr<LoxInstance>>(args[0].data)) {
+        if (auto values = dynamic_cast<ListInstance *>(std::get<shared_ptr<LoxInstance>>(args[0].data).get())) {
+            list = &values->list();
+            instance = true;
+        }
+    }
+    if (list == nullptr) {
+        throw RuntimeError("Runtime Error. parallelMap expects a list.");
+    }
+    auto function = callback(interpreter, args[1], "parallelMap", 1);
+
+    const Object *elements = list->begin();
+    std::vector<PackedValue> results(list->length());
+    inIsolates(interpreter, *function, results.size(), [&](Worker &worker, size_t i) {
+        std::vector<Object> argument{unpackValue(*worker.interpreter, packValue(elements[i]))};
+        results[i] = packValue(worker.function->call(*worker.interpreter, Arguments(argument)));
+    });
+
+    std::vector<Object> values;
+    values.reserve(results.size());
+    for (const auto &result: results) {
+        values.push_back(unpackValue(interpreter, result));
+    }
+    auto mapped = std::make_shared<LoxList>(std::move(values));
+    if (instance) {
+        return Object::make_instance_obj(std::make_shared<ListInstance>(interpreter.listClass, mapped));
+    }
+    return Object::make_obj(mapped);
+}
+
+Object nativeParallelFor(Interpreter &interpreter, Arguments args) {
+    int start = boundOf(args[0]);
+    int end = boundOf(args[1]);
+    auto function = callback(interpreter, args[2], "parallelFor", 1);
+    if (end <= start) {
+        return Object::make_nil_obj();
+    }
+    inIsolates(interpreter, *function, static_cast<size_t>(end - start), [&](Worker &worker, size_t i) {
+        std::vector<Object> argument{Object::make_obj(start + static_cast<int>(i))};
+        worker.function->call(*worker.interpreter, Arguments(argument));
+    });
+    return Object::make_nil_obj();
+}
@@ -0,0 +1,405 @@
+#include "../../include/BuiltInSerialize.hpp"
+#include "../../include/BuiltInClass.hpp"
+#include "../../include/BuiltInFile.hpp"
+#include "../../include/Interpreter.hpp"
+#include "../../include/LoxClass.hpp"
+#include "../../include/LoxInstance.hpp"
+#include "../../include/LoxList.hpp"
+#include "../../include/LoxString.hpp"
+#include "../../include/RuntimeError.hpp"
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <typeinfo>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace {
+    constexpr char magic[] = {'L', 'O', 'X', 1};
+    // nesting deeper than this is rejected instead of overflowing the stack
+    constexpr int maxDepth = 5000;
+
+    enum Tag : uint8_t {
+        TagNil,
+        TagFalse,
+        TagTrue,
+        TagInt,
+        TagDouble,
+        TagString,
+        TagList,        // [...]
+        TagListInstance,// list(...)
+        TagMap,
+        TagInstance,
+        TagReference,// a container written before, by its number
+        TagShared,   // an instance in the side table of a PackedValue
+    };
+
+    /// @brief a plain instance of a class declared in Lox code
+    bool isPlainInstance(const LoxInstance &instance) {
+        return typeid(instance) == typeid(LoxInstance) && typeid(*instance.klass) == typeid(LoxClass);
+    }
+
+    class Encoder {
+    public:
+        explicit Encoder(FileWriter *writer_, std::vector<shared_ptr<LoxInstance>> *shared_ = nullptr)
+            : writer(writer_), shared(shared_) {}
+
+        void encode(const Object &value, int depth = 0) {
+            if (depth > maxDepth) {
+                throw RuntimeError("Runtime Error. Value is nested too deeply to serialize.");
+            }
+            switch (value.data.index()) {
+                case 0:
+                    putString(TagString, std::get<shared_ptr<LoxString>>(value.data)->str());
+                    break;
+                case 1: {
+                    double number = std::get<double>(value.data);
+                    uint64_t bits;
+                    std::memcpy(&bits, &number, sizeof(bits));
+                    out += static_cast<char>(TagDouble);
+                    for (int i = 0; i < 8; i++) {
+                        out += static_cast<char>(bits >> (i * 8));
+                    }
+                    break;
+                }
+                case 2:
+                    out += static_cast<char>(std::get<bool>(value.data) ? TagTrue : TagFalse);
+                    break;
+                case 3:
+                    out += static_cast<char>(TagNil);
+                    break;
+                case 4: {
+                    auto &list = std::get<shared_ptr<LoxList>>(value.data);
+                    if (!firstVisit(list.get())) {
+                        break;
+                    }
+                    putVarint(TagList, list->length());
+                    for (const Object &element: *list) {
+                        encode(element, depth + 1);
+                    }
+                    break;
+                }
+                case 6:
+                    encodeInstance(*std::get<shared_ptr<LoxInstance>>(value.data), depth);
+                    break;
+                case 8: {
+                    // zigzag, small negative ints stay short
+                    int32_t number = std::get<int>(value.data);
+                    putVarint(TagInt, (static_cast<uint32_t>(number) << 1) ^ static_cast<uint32_t>(number >> 31));
+                    break;
+                }
+                default:
+                    throw RuntimeError("Runtime Error. " + const_cast<Object &>(value).toString() + " can not be serialized.");
+            }
+            if (writer != nullptr && out.size() >= chunkSize) {
+                writer->write(out);
+                out.clear();
+            }
+        }
+
+        /// @brief the encoding, or the unwritten rest of it when streaming
+        std::string &finish() {
+            if (writer != nullptr) {
+                writer->write(out);
+                out.clear();
+            }
+            return out;
+        }
+
+    private:
+        static constexpr size_t chunkSize = 64 * 1024;
+
+        FileWriter *writer;
+        std::vector<shared_ptr<LoxInstance>> *shared;
+        std::string out{magic, sizeof(magic)};
+        std::unordered_map<const void *, uint64_t> seen;// container, number
+
+        void encodeInstance(LoxInstance &instance, int depth) {
+            if (shared != nullptr && instance.sharedAcrossIsolates()) {
+                putVarint(TagShared, shared->size());
+                shared->push_back(instance.shared_from_this());
+                return;
+            }
+            if (auto list = dynamic_cast<ListInstance *>(&instance)) {
+                if (!firstVisit(&instance)) {
+                    return;
+                }
+                putVarint(TagListInstance, list->list().length());
+                for (const Object &element: list->list()) {
+                    encode(element, depth + 1);
+                }
+                return;
+            }
+            if (auto map = dynamic_cast<MapInstance *>(&instance)) {
+                if (!firstVisit(&instance)) {
+                    return;
+                }
+                putVarint(TagMap, map->map.size());
+                for (const auto &entry: map->map.entries()) {
+                    encode(entry.key, depth + 1);
+                    encode(entry.value, depth + 1);
+                }
+                return;
+            }
+            if (!isPlainInstance(instance)) {
+                throw RuntimeError("Runtime Error. " + instance.toString() + " can not be serialized.");
+            }
+            if (!firstVisit(&instance)) {
+                return;
+            }
+            putString(TagInstance, instance.klass->name);
+            putVarint(instance.fields.size());
+            for (const auto &[name, field]: instance.fields) {
+                putVarint(name.size());
+                out += name;
+                encode(field, depth + 1);
+            }
+        }
+
+        /// @brief number a container, or write a reference to it when it was seen
+        bool firstVisit(const void *container) {
+            auto [found, inserted] = seen.emplace(container, seen.size());
+            if (!inserted) {
+                putVarint(TagReference, found->second);
+            }
+            return inserted;
+        }
+
+        void putVarint(uint64_t value) {
+            while (value >= 0x80) {
+                out += static_cast<char>(value | 0x80);
+                value >>= 7;
+            }
+            out += static_cast<char>(value);
+        }
+
+        void putVarint(Tag tag, uint64_t value) {
+            out += static_cast<char>(tag);
+            putVarint(value);
+        }
+
+        void putString(Tag tag, const std::string &text) {
+            putVarint(tag, text.size());
+            out += text;
+        }
+    };
+
+    class Decoder {
+    public:
+        Decoder(Interpreter &interpreter_, std::string_view input_,
+                const std::vector<shared_ptr<LoxInstance>> *shared_ = nullptr)
+            : interpreter(interpreter_), input(input_), shared(shared_) {}
+
+        Object decodeAll() {
+            if (input.substr(0, sizeof(magic)) != std::string_view(magic, sizeof(magic))) {
+                throw RuntimeError("Runtime Error. Data was not made by serialize.");
+            }
+            position = sizeof(magic);
+            Object value = decode(0);
+            if (position != input.size()) {
+                corrupt();
+            }
+            return value;
+        }
+
+    private:
+        Interpreter &interpreter;
+        std::string_view input;
+        const std::vector<shared_ptr<LoxInstance>> *shared;
+        size_t position = 0;
+        std::vector<Object> containers;// by number, for references
+
+        [[noreturn]] static void corrupt() {
+            throw RuntimeError("Runtime Error. Corrupt serialized data.");
+        }
+
+        Object decode(int depth) {
+            if (depth > maxDepth || position >= input.size()) {
+                corrupt();
+            }
+            switch (static_cast<uint8_t>(input[position++])) {
+                case TagNil:
+                    return Object::make_nil_obj();
+                case TagFalse:
+                    return Object::make_obj(false);
+                case TagTrue:
+                    return Object::make_obj(true);
+                case TagInt: {
+                    auto zigzag = static_cast<uint32_t>(varint());
+                    return Object::make_obj(static_cast<int>((zigzag >> 1) ^ (~(zigzag & 1) + 1)));
+                }
+                case TagDouble: {
+                    uint64_t bits = 0;
+                    for (int i = 0; i < 8; i++) {
+                        bits |= static_cast<uint64_t>(static_cast<uint8_t>(take(1)[0])) << (i * 8);
+                    }
+                    double number;
+                    std::memcpy(&number, &bits, sizeof(number));
+                    return Object::make_obj(number);
+                }
+                case TagString:
+                    return Object::make_obj(std::string(take(varint())));
+                case TagList: {
+                    auto list = std::make_shared<LoxList>();
+                    containers.push_back(Object::make_obj(list));
+                    list->assign(elements(depth));
+                    return Object::make_obj(list);
+                }
+                case TagListInstance: {
+                    auto list = std::make_shared<LoxList>();
+                    auto instance = std::make_shared<ListInstance>(interpreter.listClass, list);
+                    containers.push_back(Object::make_instance_obj(instance));
+                    list->assign(elements(depth));
+                    return Object::make_instance_obj(instance);
+                }
+                case TagMap: {
+                    auto map = std::make_shared<MapInstance>(interpreter.mapClass);
+                    containers.push_back(Object::make_instance_obj(map));
+                    size_t entries = count();
+                    for (size_t i = 0; i < entries; i++) {
+                        Object key = decode(depth + 1);
+                        map->map.set(key, decode(depth + 1));
+                    }
+                    return Object::make_instance_obj(map);
+                }
+                case TagInstance: {
+                    auto instance = std::make_shared<LoxInstance>(globalClass(std::string(take(varint()))));
+                    containers.push_back(Object::make_instance_obj(instance));
+                    size_t entries = count();
+                    for (size_t i = 0; i < entries; i++) {
+                        std::string name(take(varint()));
+                        instance->fields[std::move(name)] = decode(depth + 1);
+                    }
+                    return Object::make_instance_obj(instance);
+                }
+                case TagReference: {
+                    uint64_t number = varint();
+                    if (number >= containers.size()) {
+                        corrupt();
+                    }
+                    return containers[number];
+                }
+                case TagShared: {
+                    uint64_t number = varint();
+                    if (shared == nullptr || number >= shared->size()) {
+                        corrupt();
+                    }
+                    return Object::make_instance_obj((*shared)[number]);
+                }
+                default:
+                    corrupt();
+            }
+        }
+
+        std::vector<Object> elements(int depth) {
+            size_t length = count();
+            std::vector<Object> values;
+            values.reserve(length);
+            for (size_t i = 0; i < length; i++) {
+                values.push_back(decode(depth + 1));
+            }
+            return values;
+        }
+
+        uint64_t varint() {
+            uint64_t value = 0;
+            for (int shift = 0; shift < 64; shift += 7) {
+                auto byte = static_cast<uint8_t>(take(1)[0]);
+                value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+                if ((byte & 0x80) == 0) {
+                    return value;
+                }
+            }
+            corrupt();
+        }
+
+        /// @brief an element count, every element takes at least one byte
+        size_t count() {
+            uint64_t value = varint();
+            if (value > input.size() - position) {
+                corrupt();
+            }
+            return static_cast<size_t>(value);
+        }
+
+        std::string_view take(uint64_t length) {
+            if (length > input.size() - position) {
+                corrupt();
+            }
+            auto bytes = input.substr(position, static_cast<size_t>(length));
+            position += static_cast<size_t>(length);
+            return bytes;
+        }
+
+        shared_ptr<LoxClass> globalClass(const std::string &name) {
+            Object value;
+            try {
+                value = interpreter.globals->get(Token(IDENTIFIER, name, Object::make_nil_obj(), -1));
+            } catch (RuntimeError &) {
+                throw RuntimeError("Runtime Error. Unknown class '" + name + "' in serialized data.");
+            }
+            if (!std::holds_alternative<shared_ptr<LoxClass>>(value.data)) {
+                throw RuntimeError("Runtime Error. '" + name + "' in serialized data is not a class.");
+            }
+            return std::get<shared_ptr<LoxClass>>(value.data);
+        }
+    };
+}
+
+PackedValue packValue(const Object &value) {
+    PackedValue packed;
+    switch (value.data.index()) {
+        case 0:
+        case 1:
+        case 2:
+        case 3:
+        case 8:
+            packed.immediate = value;
+            return packed;
+    }
+    Encoder encoder(nullptr, &packed.shared);
+    encoder.encode(value);
+    packed.bytes = std::move(encoder.finish());
+    return packed;
+}
+
+Object unpackValue(Interpreter &interpreter, const PackedValue &packed) {
+    if (packed.bytes.empty()) {
+        return packed.immediate;
+    }
+    return Decoder(interpreter, packed.bytes, &packed.shared).decodeAll();
+}
+
+Object nativeSerialize(Interpreter &interpreter, Arguments args) {
+    if (args.size() != 1 && args.size() != 2) {
+        throw RuntimeError("Runtime Error. Expected 1 or 2 arguments but got " + std::to_string(args.size()) + ".");
+    }
+    FileWriter *writer = nullptr;
+    if (args.size() == 2) {
+        if (std::holds_alternative<shared_ptr<LoxInstance>>(args[1].data)) {
+            writer = dynamic_cast<FileWriter *>(std::get<shared_ptr<LoxInstance>>(args[1].data).get());
+        }
+        if (writer == nullptr) {
+            throw RuntimeError("Runtime Error. serialize writes to a file opened with open(path, \"w\").");
+        }
+    }
+    Encoder encoder(writer);
+    encoder.encode(args[0]);
+    std::string &bytes = encoder.finish();
+    if (writer != nullptr) {
+        return Object::make_nil_obj();
+    }
+    return Object::make_obj(std::move(bytes));
+}
+
+Object nativeDeserialize(Interpreter &interpreter, Arguments args) {
+    if (!std::holds_alternative<shared_ptr<LoxString>>(args[0].data)) {
+        throw RuntimeError("Runtime Error. deserialize expects a string made by serialize.");
+    }
+    // keeps the bytes alive while they are decoded
+    auto bytes = std::get<shared_ptr<LoxString>>(args[0].data);
+    return Decoder(interpreter, bytes->str()).decodeAll();
+}
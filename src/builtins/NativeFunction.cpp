@@ -0,0 +1,78 @@
+#include "../../include/NativeFunction.hpp"
+#include "../../include/BuiltInAsync.hpp"
+#include "../../include/BuiltInFile.hpp"
+#include "../../include/BuiltInFun.hpp"
+#include "../../include/BuiltInIo.hpp"
+#include "../../include/BuiltInIsolate.hpp"
+#include "../../include/BuiltInJson.hpp"
+#include "../../include/BuiltInParallel.hpp"
+#include "../../include/BuiltInSerialize.hpp"
+#include "../../include/LoxInstance.hpp"
+#include <utility>
+
+namespace {
+    struct NativeEntry {
+        const char *name;
+        size_t arity;
+        NativeFunction::Fn fn;
+    };
+
+    // the global natives, add new builtins here
+    constexpr NativeEntry registry[] = {
+        {"clock", 0, nativeClock},
+        {"type", 1, nativeType},
+        {"print", LoxCallable::VARIADIC, nativePrint},
+        {"input", 0, nativeInput},
+        {"flush", 0, nativeFlush},
+        {"open", 2, nativeOpen},
+        {"readLines", 1, nativeReadLines},
+        {"readAll", 1, nativeReadAll},
+        {"serialize", LoxCallable::VARIADIC, nativeSerialize},
+        {"deserialize", 1, nativeDeserialize},
+        {"jsonParse", 1, nativeJsonParse},
+        {"jsonStringify", 1, nativeJsonStringify},
+        {"spawn", LoxCallable::VARIADIC, nativeSpawn},
+        {"channel", 0, nativeChannel},
+        {"parallelMap", 2, nativeParallelMap},
+        {"parallelFor", 3, nativeParallelFor},
+        {"readFile", LoxCallable::VARIADIC, nativeReadFile},
+        {"writeFile", LoxCallable::VARIADIC, nativeWriteFile},
+        {"sleep", LoxCallable::VARIADIC, nativeSleep},
+        {"exec", LoxCallable::VARIADIC, nativeExec},
+        {"task", LoxCallable::VARIADIC, nativeTask},
+    };
+}
+
+void defineNatives(Environment &globals) {
+    for (const auto &entry: registry) {
+        globals.define(entry.name, Object::make_obj(std::make_shared<NativeFunction>(entry.name, entry.arity, entry.fn)));
+    }
+}
+
+// ------------------------------------------------------------------------------------------
+NativeFunction::NativeFunction(string name_, size_t arity_, Fn fn_)
+    : name(std::move(name_)), aritys(arity_), fn(fn_) {}
+
+size_t NativeFunction::arity() { return aritys; }
+
+Object NativeFunction::call(Interpreter &interpreter, Arguments arguments) {
+    return fn(interpreter, arguments);
+}
+
+string NativeFunction::toString() { return "<native fn: " + name + ">"; }
+
+// ------------------------------------------------------------------------------------------
+NativeMethod::NativeMethod(string name_, size_t arity_, Fn fn_, shared_ptr<LoxInstance> self_)
+    : name(std::move(name_)), aritys(arity_), fn(fn_), self(std::move(self_)) {}
+
+shared_ptr<NativeMethod> NativeMethod::bind(shared_ptr<LoxInstance> instance) {
+    return std::make_shared<NativeMethod>(name, aritys, fn, std::move(instance));
+}
+
+size_t NativeMethod::arity() { return aritys; }
+
+Object NativeMethod::call(Interpreter &interpreter, Arguments arguments) {
+    return fn(interpreter, *self, arguments);
+}
+
+string NativeMethod::toString() { return "<native method: " + name + ">"; }
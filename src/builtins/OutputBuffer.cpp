@@ -0,0 +1,110 @@
+#include "../../include/OutputBuffer.hpp"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <utility>
+
+OutputBuffer::OutputBuffer(int fd, size_t capacity)
+    : fd{fd}, capacity{capacity}, lineBuffered{::isatty(fd) != 0}, data{new char[capacity]} {}
+
+OutputBuffer::OutputBuffer(std::string &sink, size_t capacity)
+    : fd{-1}, sink{&sink}, capacity{capacity}, lineBuffered{false}, data{new char[capacity]} {}
+
+OutputBuffer::~OutputBuffer() {
+    flush();
+}
+
+OutputBuffer &OutputBuffer::standard() {
+    // a function local static is destroyed by exit(), which flushes it
+    static OutputBuffer output(STDOUT_FILENO);
+    static const bool configured = [] {
+        if (const char *mode = std::getenv("LOX_LINE_BUFFERED")) {
+            output.setLineBuffered(std::string(mode) != "0");
+        }
+        return true;
+    }();
+    (void) configured;
+    return output;
+}
+
+void OutputBuffer::write(std::string_view text) {
+    std::lock_guard<std::mutex> guard(lock);
+    append(text);
+}
+
+void OutputBuffer::put(char c) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (size == capacity) {
+        flushBuffer();
+    }
+    data[size++] = c;
+}
+
+void OutputBuffer::endLine() {
+    writeLine({});
+}
+
+void OutputBuffer::writeLine(std::string_view text) {
+    std::lock_guard<std::mutex> guard(lock);
+    append(text);
+    append("\n");
+    if (lineBuffered) {
+        flushBuffer();
+    }
+}
+
+void OutputBuffer::flush() {
+    std::lock_guard<std::mutex> guard(lock);
+    flushBuffer();
+}
+
+int OutputBuffer::takeError() {
+    std::lock_guard<std::mutex> guard(lock);
+    return std::exchange(error, 0);
+}
+
+void OutputBuffer::append(std::string_view text) {
+    if (text.size() > capacity - size) {
+        flushBuffer();
+        // too large to be worth copying, hand it to the kernel directly
+        if (text.size() >= capacity) {
+            writeAll(text.data(), text.size());
+            return;
+        }
+    }
+    std::memcpy(data.get() + size, text.data(), text.size());
+    size += text.size();
+}
+
+void OutputBuffer::flushBuffer() {
+    if (size == 0) {
+        return;
+    }
+    writeAll(data.get(), size);
+    size = 0;
+}
+
+/// @brief write(2) until everything is written, output that cannot be
+/// written (closed pipe, full disk) is dropped and its errno kept for takeError()
+void OutputBuffer::writeAll(const char *bytes, size_t length) {
+    if (sink != nullptr) {
+        sink->append(bytes, length);
+        return;
+    }
+    while (length > 0) {
+        ssize_t written = ::write(fd, bytes, length);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            if (error == 0) {
+                error = written < 0 ? errno : EIO;
+            }
+            return;
+        }
+        bytes += written;
+        length -= static_cast<size_t>(written);
+    }
+}
@@ -0,0 +1,254 @@
+#include "../../include/TypedArray.hpp"
+#include "../../include/ArrayKernels.hpp"
+#include "../../include/BuiltInClass.hpp"
+#include "../../include/BuiltInIo.hpp"
+#include "../../include/LoxList.hpp"
+#include "../../include/NativeFunction.hpp"
+#include "../../include/RuntimeError.hpp"
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <variant>
+
+namespace {
+    constexpr size_t bufferAlignment = 64;
+    // lengths stay lox integers, so len() and every index are exact
+    constexpr size_t maxLength = std::numeric_limits<int>::max();
+
+    template<typename T>
+    T *allocateElements(size_t length) {
+        if (length == 0) {
+            return nullptr;
+        }
+        if (length > maxLength || length > (SIZE_MAX - bufferAlignment) / sizeof(T)) {
+            throw RuntimeError("Runtime Error. Typed array length " + std::to_string(length) + " is too large.");
+        }
+        // aligned_alloc wants the size to be a multiple of the alignment
+        size_t bytes = (length * sizeof(T) + bufferAlignment - 1) / bufferAlignment * bufferAlignment;
+        void *memory = std::aligned_alloc(bufferAlignment, bytes);
+        if (memory == nullptr) {
+            throw RuntimeError("Runtime Error. Out of memory allocating a typed array.");
+        }
+        return static_cast<T *>(memory);
+    }
+
+    bool isNumber(const Object &value) {
+        return std::holds_alternative<double>(value.data) || std::holds_alternative<int>(value.data);
+    }
+
+    double numberOf(const Object &value) {
+        if (std::holds_alternative<int>(value.data)) {
+            return std::get<int>(value.data);
+        }
+        return std::get<double>(value.data);
+    }
+
+    template<typename T>
+    TypedArray<T> &arrayOf(LoxInstance &self) {
+        return static_cast<TypedArray<T> &>(self);
+    }
+
+    /// @brief the argument as a typed array of the same kind and length as self
+    template<typename T>
+    TypedArray<T> &sameShape(LoxInstance &self, const Object &argument) {
+        TypedArray<T> *other = nullptr;
+        if (std::holds_alternative<shared_ptr<LoxInstance>>(argument.data)) {
+            other = dynamic_cast<TypedArray<T> *>(std::get<shared_ptr<LoxInstance>>(argument.data).get());
+        }
+        if (other == nullptr) {
+            throw RuntimeError("Runtime Error. Argument must be a " + self.klass->name + ".");
+        }
+        if (other->length() != arrayOf<T>(self).length()) {
+            throw RuntimeError("Runtime Error. Array lengths differ: " + std::to_string(arrayOf<T>(self).length()) +
+                               " and " + std::to_string(other->length()) + ".");
+        }
+        return *other;
+    }
+}
+
+// ------------------------------------------------------------------------------------------
+template<>
+double TypedArray<double>::element(const Object &value) {
+    if (!isNumber(value)) {
+        throw RuntimeError("Runtime Error. Float64Array elements must be numbers.");
+    }
+    return numberOf(value);
+}
+
+template<>
+int64_t TypedArray<int64_t>::element(const Object &value) {
+    if (!isNumber(value) || numberOf(value) != std::floor(numberOf(value)) ||
+        std::abs(numberOf(value)) >= 0x1p63) {
+        throw RuntimeError("Runtime Error. Int64Array elements must be integers.");
+    }
+    if (std::holds_alternative<int>(value.data)) {
+        return std::get<int>(value.data);
+    }
+    return static_cast<int64_t>(std::get<double>(value.data));
+}
+
+template<>
+Object TypedArray<double>::box(double value) {
+    return Object::make_obj(value);
+}
+
+// lox integers are 32 bits, wider values come back as doubles
+template<>
+Object TypedArray<int64_t>::box(int64_t value) {
+    if (value >= std::numeric_limits<int>::min() && value <= std::numeric_limits<int>::max()) {
+        return Object::make_obj(static_cast<int>(value));
+    }
+    return Object::make_obj(static_cast<double>(value));
+}
+
+// ------------------------------------------------------------------------------------------
+template<typename T>
+static Object arraySum(Interpreter &interpreter, LoxInstance &self, Arguments args) {
+    auto &array = arrayOf<T>(self);
+    return TypedArray<T>::box(ArrayKernels::sum(array.data(), array.length()));
+}
+
+// min and max of an empty array are nil
+template<typename T>
+static Object arrayMin(Interpreter &interpreter, LoxInstance &self, Arguments args) {
+    auto &array = arrayOf<T>(self);
+    if (array.length() == 0) {
+        return Object::make_nil_obj();
+    }
+    return TypedArray<T>::box(ArrayKernels::min(array.data(), array.length()));
+}
+
+template<typename T>
+static Object arrayMax(Interpreter &interpreter, LoxInstance &self, Arguments args) {
+    auto &array = arrayOf<T>(self);
+    if (array.length() == 0) {
+        return Object::make_nil_obj();
+    }
+    return TypedArray<T>::box(ArrayKernels::max(array.data(), array.length()));
+}
+
+template<typename T>
+static Object arrayDot(Interpreter &interpreter, LoxInstance &self, Arguments args) {
+    auto &array = arrayOf<T>(self);
+    auto &other = sameShape<T>(self, args[0]);
+    return TypedArray<T>::box(ArrayKernels::dot(array.data(), other.data(), array.length()));
+}
+
+// scale, add and fill work in place and return the array for chaining
+template<typename T>
+static Object arrayScale(Interpreter &interpreter, LoxInstance &self, Arguments args) {
+    auto &array = arrayOf<T>(self);
+    ArrayKernels::scale(array.data(), array.length(), TypedArray<T>::element(args[0]));
+    return Object::make_instance_obj(self.shared_from_this());
+}
+
+template<typename T>
+static Object arrayAdd(Interpreter &interpreter, LoxInstance &self, Arguments args) {
+    auto &array = arrayOf<T>(self);
+    auto &other = sameShape<T>(self, args[0]);
+    ArrayKernels::add(array.data(), other.data(), array.length());
+    return Object::make_instance_obj(self.shared_from_this());
+}
+
+template<typename T>
+static Object arrayFill(Interpreter &interpreter, LoxInstance &self, Arguments args) {
+    auto &array = arrayOf<T>(self);
+    ArrayKernels::fill(array.data(), array.length(), TypedArray<T>::element(args[0]));
+    return Object::make_instance_obj(self.shared_from_this());
+}
+
+template<typename T>
+static Object arrayLen(Interpreter &interpreter, LoxInstance &self, Arguments args) {
+    return Object::make_obj(static_cast<int>(arrayOf<T>(self).length()));
+}
+
+// ------------------------------------------------------------------------------------------
+template<typename T>
+TypedArrayClass<T>::TypedArrayClass(const string &name) : LoxClass(name, nullptr, {}) {
+    this->nativeMethods["sum"] = std::make_shared<NativeMethod>("sum", 0, arraySum<T>);
+    this->nativeMethods["min"] = std::make_shared<NativeMethod>("min", 0, arrayMin<T>);
+    this->nativeMethods["max"] = std::make_shared<NativeMethod>("max", 0, arrayMax<T>);
+    this->nativeMethods["dot"] = std::make_shared<NativeMethod>("dot", 1, arrayDot<T>);
+    this->nativeMethods["scale"] = std::make_shared<NativeMethod>("scale", 1, arrayScale<T>);
+    this->nativeMethods["add"] = std::make_shared<NativeMethod>("add", 1, arrayAdd<T>);
+    this->nativeMethods["fill"] = std::make_shared<NativeMethod>("fill", 1, arrayFill<T>);
+    this->nativeMethods["len"] = std::make_shared<NativeMethod>("len", 0, arrayLen<T>);
+}
+
+/// @brief the argument is either a length or a list literal to copy
+template<typename T>
+Object TypedArrayClass<T>::call(Interpreter &interpreter, Arguments args) {
+    const Object &argument = args[0];
+    const LoxList *list = nullptr;
+    if (std::holds_alternative<shared_ptr<LoxList>>(argument.data)) {
+        list = std::get<shared_ptr<LoxList>>(argument.data).get();
+    } else if (std::holds_alternative<shared_ptr<LoxInstance>>(argument.data)) {
+        if (auto values = dynamic_cast<ListInstance *>(std::get<shared_ptr<LoxInstance>>(argument.data).get())) {
+            list = &values->list();
+        }
+    }
+    if (list != nullptr) {
+        auto array = std::make_shared<TypedArray<T>>(shared_from_this(), list->length());
+        const Object *elements = list->begin();
+        for (size_t i = 0; i < list->length(); i++) {
+            array->data()[i] = TypedArray<T>::element(elements[i]);
+        }
+        return Object::make_instance_obj(array);
+    }
+    if (!isNumber(argument)) {
+        throw RuntimeError("Runtime Error. " + this->name + " expects a length or a list.");
+    }
+    double length = numberOf(argument);
+    if (length < 0 || length != std::floor(length)) {
+        throw RuntimeError("Runtime Error. " + this->name + " length must be a non-negative integer.");
+    }
+    if (length > static_cast<double>(maxLength)) {
+        throw RuntimeError("Runtime Error. " + this->name + " length must be at most " + std::to_string(maxLength) + ".");
+    }
+    auto array = std::make_shared<TypedArray<T>>(shared_from_this(), static_cast<size_t>(length));
+    ArrayKernels::fill(array->data(), array->length(), T{0});
+    return Object::make_instance_obj(array);
+}
+
+template<typename T>
+size_t TypedArrayClass<T>::arity() { return 1; }
+
+// ------------------------------------------------------------------------------------------
+template<typename T>
+TypedArray<T>::TypedArray(shared_ptr<LoxClass> klass, size_t length)
+    : LoxInstance(std::move(klass)), buffer(allocateElements<T>(length)), size(length) {}
+
+template<typename T>
+Object TypedArray<T>::getIndex(const Object &key) {
+    return box(buffer[position(key)]);
+}
+
+template<typename T>
+void TypedArray<T>::setIndex(const Object &key, Object value) {
+    buffer[position(key)] = element(value);
+}
+
+/// @brief the element index of a subscript, negative indices count from the end
+template<typename T>
+size_t TypedArray<T>::position(const Object &key) const {
+    if (!isNumber(key) || numberOf(key) != std::floor(numberOf(key))) {
+        throw RuntimeError("Runtime Error. Indices must be integers.");
+    }
+    double index = numberOf(key);
+    if (index < 0) {
+        index += static_cast<double>(size);
+    }
+    if (index < 0 || index >= static_cast<double>(size)) {
+        std::string shown;
+        stringify(key, shown);
+        throw RuntimeError("Runtime Error. Index out of range. Index is " + shown + " but object size is " + std::to_string(size));
+    }
+    return static_cast<size_t>(index);
+}
+
+template class TypedArrayClass<double>;
+template class TypedArrayClass<int64_t>;
+template class TypedArray<double>;
+template class TypedArray<int64_t>;
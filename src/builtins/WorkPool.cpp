@@ -0,0 +1,168 @@
+#include "../../include/WorkPool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+struct WorkPool::Loop {
+    struct alignas(64) Range {
+        std::mutex lock;
+        size_t begin = 0;
+        size_t end = 0;
+    };
+
+    Loop(size_t count, size_t slots, const Body &body_)
+        : body(body_), ranges(new Range[slots]), slots(slots) {
+        for (size_t i = 0; i < slots; i++) {
+            ranges[i].begin = count * i / slots;
+            ranges[i].end = count * (i + 1) / slots;
+        }
+    }
+
+    const Body &body;// only called while the caller waits in parallelFor
+    std::unique_ptr<Range[]> ranges;
+    size_t slots;
+
+    std::mutex lock;
+    std::condition_variable idle;
+    size_t joined = 0;
+    size_t active = 0;
+    bool closed = false;// set by the caller when it is done, no one joins after
+    std::exception_ptr error;
+    std::atomic<bool> failed{false};
+
+    void participate() {
+        size_t self;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (closed || joined == slots) {
+                return;
+            }
+            self = joined++;
+            active++;
+        }
+        size_t begin, end;
+        while (!failed.load(std::memory_order_relaxed) && take(self, begin, end)) {
+            try {
+                body(self, begin, end);
+            } catch (...) {
+                std::lock_guard<std::mutex> guard(lock);
+                if (!error) {
+                    error = std::current_exception();
+                }
+                failed = true;
+            }
+        }
+        std::lock_guard<std::mutex> guard(lock);
+        if (--active == 0) {
+            idle.notify_all();
+        }
+    }
+
+    /// @brief the next chunk of the own range, stealing when it is empty
+    bool take(size_t self, size_t &begin, size_t &end) {
+        while (true) {
+            {
+                Range &own = ranges[self];
+                std::lock_guard<std::mutex> guard(own.lock);
+                size_t left = own.end - own.begin;
+                if (left > 0) {
+                    begin = own.begin;
+                    own.begin += std::max<size_t>(1, left / 8);
+                    end = own.begin;
+                    return true;
+                }
+            }
+            if (!steal(self)) {
+                return false;
+            }
+        }
+    }
+
+    /// @brief move the back half of the largest other range to the own one
+    bool steal(size_t self) {
+        while (true) {
+            size_t victim = slots;
+            size_t most = 0;
+            for (size_t i = 0; i < slots; i++) {
+                if (i == self) {
+                    continue;
+                }
+                std::lock_guard<std::mutex> guard(ranges[i].lock);
+                if (ranges[i].end - ranges[i].begin > most) {
+                    most = ranges[i].end - ranges[i].begin;
+                    victim = i;
+                }
+            }
+            if (victim == slots) {
+                return false;
+            }
+            size_t begin, end;
+            {
+                Range &range = ranges[victim];
+                std::lock_guard<std::mutex> guard(range.lock);
+                size_t left = range.end - range.begin;
+                if (left == 0) {
+                    continue;// emptied since it was looked at
+                }
+                end = range.end;
+                range.end -= (left + 1) / 2;
+                begin = range.end;
+            }
+            Range &own = ranges[self];
+            std::lock_guard<std::mutex> guard(own.lock);
+            own.begin = begin;
+            own.end = end;
+            return true;
+        }
+    }
+};
+
+WorkPool &WorkPool::shared() {
+    // never destroyed, idle threads are simply ended with the process
+    static WorkPool *pool = new WorkPool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+    return *pool;
+}
+
+WorkPool::WorkPool(size_t threadCount) {
+    for (size_t i = 0; i < threadCount; i++) {
+        threads.emplace_back(&WorkPool::workerMain, this);
+    }
+}
+
+void WorkPool::workerMain() {
+    while (true) {
+        std::shared_ptr<Loop> loop;
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            wake.wait(guard, [this] { return !queue.empty(); });
+            loop = std::move(queue.front());
+            queue.pop_front();
+        }
+        loop->participate();
+    }
+}
+
+void WorkPool::parallelFor(size_t count, const Body &body) {
+    if (count == 0) {
+        return;
+    }
+    auto loop = std::make_shared<Loop>(count, participants(), body);
+    if (count > 1 && !threads.empty()) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            for (size_t i = 0; i < threads.size(); i++) {
+                queue.push_back(loop);
+            }
+        }
+        wake.notify_all();
+    }
+    loop->participate();
+    {
+        std::unique_lock<std::mutex> guard(loop->lock);
+        loop->closed = true;
+        loop->idle.wait(guard, [&] { return loop->active == 0; });
+    }
+    if (loop->error) {
+        std::rethrow_exception(loop->error);
+    }
+}
@@ -0,0 +1,247 @@
+#include "../../include/Generator.hpp"
+#include "../../include/Interpreter.hpp"
+#include "../../include/LoxClass.hpp"
+#include "../../include/NativeFunction.hpp"
+#include "../../include/RuntimeError.hpp"
+#include "../../include/RuntimeException.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <utility>
+
+namespace {
+    size_t guardSize() {
+        static const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        return page;
+    }
+
+    constexpr size_t defaultStackSize = 8 * 1024 * 1024;
+    // a smaller LOX_GENERATOR_STACK_KB would leave no room above stackReserve
+    constexpr size_t minimumStackSize = 64 * 1024;
+    // what stays committed in a cached stack, the rest is given back
+    constexpr size_t warmStackSize = 64 * 1024;
+
+    // finished generators hand their stacks back here, so a pipeline that
+    // makes a generator per stage does not map and unmap one every time
+    struct StackCache {
+        static constexpr size_t capacity = 8;
+        std::vector<char *> stacks;
+
+        ~StackCache() {
+            for (char *stack: stacks) {
+                ::munmap(stack, Generator::stackSize() + guardSize());
+            }
+        }
+    };
+    thread_local StackCache stackCache;
+
+    /// @brief every live generator takes two memory mappings, the stack and its
+    /// guard page, so ENOMEM usually means vm.max_map_count was reached
+    [[noreturn]] void stackError(int error) {
+        string message = "Runtime Error. Could not map a generator stack: " + string(std::strerror(error)) + ".";
+        if (error == ENOMEM) {
+            message += " Too many live generators for the memory map limit (vm.max_map_count)?";
+        }
+        throw RuntimeError(message);
+    }
+
+    char *allocateStack() {
+        if (!stackCache.stacks.empty()) {
+            char *stack = stackCache.stacks.back();
+            stackCache.stacks.pop_back();
+            return stack;
+        }
+        size_t size = Generator::stackSize() + guardSize();
+        void *memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+        if (memory == MAP_FAILED) {
+            stackError(errno);
+        }
+        // the stack grows down, overflowing it hits this page and faults;
+        // without the guard an overflow would write over other memory
+        if (::mprotect(memory, guardSize(), PROT_NONE) != 0) {
+            int error = errno;
+            ::munmap(memory, size);
+            stackError(error);
+        }
+        return static_cast<char *>(memory);
+    }
+
+    void releaseStack(char *stack) {
+        if (stackCache.stacks.size() < StackCache::capacity) {
+            // a body that recursed deep committed pages the next one may not need
+            ::madvise(stack + guardSize(), Generator::stackSize() - warmStackSize, MADV_DONTNEED);
+            stackCache.stacks.push_back(stack);
+        } else {
+            ::munmap(stack, Generator::stackSize() + guardSize());
+        }
+    }
+
+    Generator &generatorOf(LoxInstance &self) {
+        return static_cast<Generator &>(self);
+    }
+
+    Object generatorNext(Interpreter &interpreter, LoxInstance &self, Arguments args) {
+        return generatorOf(self).resume(interpreter, Object::make_nil_obj());
+    }
+
+    Object generatorSend(Interpreter &interpreter, LoxInstance &self, Arguments args) {
+        return generatorOf(self).resume(interpreter, args[0]);
+    }
+
+    Object generatorDone(Interpreter &interpreter, LoxInstance &self, Arguments args) {
+        return Object::make_obj(generatorOf(self).isDone());
+    }
+
+    Object generatorClose(Interpreter &interpreter, LoxInstance &self, Arguments args) {
+        generatorOf(self).close(interpreter);
+        return Object::make_nil_obj();
+    }
+
+    const shared_ptr<LoxClass> &generatorClass() {
+        static const auto klass = [] {
+            auto generator = std::make_shared<LoxClass>("Generator", nullptr, map<string, shared_ptr<LoxFunction>>{});
+            generator->nativeMethods["next"] = std::make_shared<NativeMethod>("next", 0, generatorNext);
+            generator->nativeMethods["send"] = std::make_shared<NativeMethod>("send", 1, generatorSend);
+            generator->nativeMethods["done"] = std::make_shared<NativeMethod>("done", 0, generatorDone);
+            generator->nativeMethods["close"] = std::make_shared<NativeMethod>("close", 0, generatorClose);
+            return generator;
+        }();
+        return klass;
+    }
+}
+
+Generator::Generator(shared_ptr<Function> declaration_, shared_ptr<Environment> environment_)
+    : LoxInstance(generatorClass()), declaration(std::move(declaration_)), environment(std::move(environment_)) {}
+
+Generator::~Generator() {
+    if (started && !finished) {
+        // unwind the suspended body, unless its interpreter is already gone
+        if (auto alive = owner.lock()) {
+            try {
+                close(*alive);
+            } catch (...) {
+            }
+        }
+    }
+    if (stack != nullptr) {
+        releaseStack(stack);
+    }
+}
+
+Object Generator::resume(Interpreter &interpreter_, Object sent) {
+    if (finished) {
+        return Object::make_nil_obj();
+    }
+    if (running) {
+        throw RuntimeError("Runtime Error. Generator is already running.");
+    }
+    if (!started) {
+        stack = allocateStack();
+        getcontext(&context);
+        context.uc_stack.ss_sp = stack + guardSize();
+        context.uc_stack.ss_size = stackSize();
+        context.uc_link = nullptr;
+        auto address = reinterpret_cast<uintptr_t>(this);
+        makecontext(&context, reinterpret_cast<void (*)()>(entry), 2,
+                    static_cast<unsigned>(address >> 32), static_cast<unsigned>(address));
+        owner = interpreter_.weak_from_this();
+        interpreter = &interpreter_;
+        started = true;
+    } else if (interpreter != &interpreter_) {
+        throw RuntimeError("Runtime Error. A generator can only be resumed by the interpreter that started it.");
+    }
+
+    transfer = std::move(sent);
+    switchIn();
+    if (finished && stack != nullptr) {
+        releaseStack(stack);
+        stack = nullptr;
+    }
+    if (error) {
+        auto failure = std::move(error);
+        error = nullptr;
+        std::rethrow_exception(failure);
+    }
+    return std::move(transfer);
+}
+
+Object Generator::yield(Object value) {
+    transfer = std::move(value);
+    swapcontext(&context, &caller);
+    if (closing) {
+        throw Closing{};
+    }
+    return std::move(transfer);
+}
+
+void Generator::close(Interpreter &interpreter_) {
+    if (!started) {
+        finished = true;
+        return;
+    }
+    closing = true;
+    resume(interpreter_, Object::make_nil_obj());
+}
+
+void Generator::entry(unsigned high, unsigned low) {
+    auto address = (static_cast<uintptr_t>(high) << 32) | static_cast<uintptr_t>(low);
+    reinterpret_cast<Generator *>(address)->run();
+}
+
+void Generator::run() {
+    try {
+        // switchIn made the call's environment current
+        interpreter->executeBlock(declaration->body, interpreter->environment);
+    } catch (const ReturnError &value) {
+        returned = value.getReturnValue();
+    } catch (const Closing &) {
+    } catch (...) {
+        error = std::current_exception();
+    }
+    finished = true;
+    transfer = Object::make_nil_obj();
+    // never resumed again, the stack is released by whoever resumed it
+    swapcontext(&context, &caller);
+}
+
+size_t Generator::stackSize() {
+    static const size_t size = [] {
+        size_t bytes = defaultStackSize;
+        if (const char *kilobytes = std::getenv("LOX_GENERATOR_STACK_KB")) {
+            char *end = nullptr;
+            unsigned long long value = std::strtoull(kilobytes, &end, 10);
+            if (end != kilobytes && *end == '\0' && value <= SIZE_MAX / 1024) {
+                bytes = std::max(static_cast<size_t>(value) * 1024, minimumStackSize);
+            }
+        }
+        // whole pages, the stack starts right after the guard page
+        return (bytes + guardSize() - 1) / guardSize() * guardSize();
+    }();
+    return size;
+}
+
+bool Generator::stackExhausted() const {
+    char marker;
+    auto position = reinterpret_cast<uintptr_t>(&marker);
+    return position < reinterpret_cast<uintptr_t>(stack) + guardSize() + stackReserve;
+}
+
+/// @brief run the body until it switches back, with the interpreter's state
+/// exchanged for the body's while it runs
+void Generator::switchIn() {
+    std::swap(interpreter->environment, environment);
+    std::swap(interpreter->argumentStack, argumentStack);
+    Generator *outer = interpreter->generator;
+    interpreter->generator = this;
+    running = true;
+    swapcontext(&caller, &context);
+    running = false;
+    interpreter->generator = outer;
+    std::swap(interpreter->argumentStack, argumentStack);
+    std::swap(interpreter->environment, environment);
+}
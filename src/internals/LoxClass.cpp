@@ -19,11 +19,9 @@ LoxClass::LoxClass(
     shared_ptr<LoxClass> superclass_,
     map<string, shared_ptr<LoxFunction>> methods_) : name(name_), superclass(superclass_), methods(methods_) {}
 
-Object LoxClass::call(
-    shared_ptr<Interpreter> interpreter,
-    vector<Object> arguments)
+Object LoxClass::call(Interpreter &interpreter, Arguments arguments)
 {
-    auto instance = std::make_shared<LoxInstance>(*this);
+    auto instance = std::make_shared<LoxInstance>(shared_from_this());
     // auto instance = shared_ptr<LoxInstance>(new LoxInstance(*this));
     shared_ptr<LoxFunction> initializer = findMethod("init");
     if (initializer != nullptr)
@@ -57,4 +55,18 @@ shared_ptr<LoxFunction> LoxClass::findMethod(string name)
         return superclass->findMethod(name);
     }
     return nullptr;
+}
+
+shared_ptr<NativeMethod> LoxClass::findNativeMethod(const string &name)
+{
+    auto searched = nativeMethods.find(name);
+    if (searched != nativeMethods.end())
+    {
+        return searched->second;
+    }
+    if (superclass != nullptr)
+    {
+        return superclass->findNativeMethod(name);
+    }
+    return nullptr;
 }
\ No newline at end of file
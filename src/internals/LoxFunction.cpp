@@ -2,8 +2,10 @@
 
 #include "../../include/LoxFunction.hpp"
 #include "../../include/Environment.hpp"
+#include "../../include/Generator.hpp"
 #include "../../include/Interpreter.hpp"
 #include "../../include/LoxInstance.hpp"
+#include "../../include/LoxString.hpp"
 #include "../../include/RuntimeException.hpp"
 #include "../../include/Stmt.hpp"
 #include "../../include/Token.hpp"
@@ -16,39 +18,65 @@ using std::shared_ptr;
 using std::string;
 using std::vector;
 
+static const LoxString *thisName() {
+    static const LoxString *name = LoxString::intern("this").get();
+    return name;
+}
+
 LoxFunction::LoxFunction(shared_ptr<Function> declaration_, shared_ptr<Environment> closure_, bool isInitializer_)
     : declaration(declaration_), closure(closure_),
       isInitializer(isInitializer_) {}
 
 size_t LoxFunction::arity() { return declaration->params.size(); }
 
-Object LoxFunction::call(shared_ptr<Interpreter> interpreter, vector<Object> arguments) {
-    auto environment = std::make_shared<Environment>(closure);
-    // shared_ptr<Environment> environment(new Environment(closure));
-
-    for (size_t i = 0; i < declaration->params.size(); i++) {
-        environment->define(declaration->params[i].first.lexeme, arguments[i]);
+Object LoxFunction::call(Interpreter &interpreter, Arguments arguments) {
+    if (declaration->isGenerator) {
+        return Object::make_instance_obj(coroutine(arguments));
+    }
+    auto profile = interpreter.profile.get();
+    if (profile != nullptr) {
+        profile->enter(declaration->nodeId, arguments);
     }
+    auto environment = environmentFor(arguments);
     try {
-        interpreter->executeBlock(declaration->body, environment);
+        interpreter.executeBlock(declaration->body, environment);
     } catch (ReturnError const &returnValue) {
         if (isInitializer) {
-            return closure->getAt(0, "this");
+            return closure->getAt(0, thisName());
+        }
+        if (profile != nullptr) {
+            profile->leave(declaration->nodeId, returnValue.getReturnValue());
         }
         return returnValue.getReturnValue();
     }
     if (isInitializer) {
-        return closure->getAt(0, "this");
+        return closure->getAt(0, thisName());
     }
     return Object::make_nil_obj();
 }
 
+shared_ptr<Generator> LoxFunction::coroutine(Arguments arguments) {
+    // the body runs when the generator is resumed
+    return std::make_shared<Generator>(declaration, environmentFor(arguments));
+}
+
+shared_ptr<Environment> LoxFunction::environmentFor(Arguments &arguments) {
+    auto environment = std::make_shared<Environment>(closure);
+    // shared_ptr<Environment> environment(new Environment(closure));
+
+    // the argument slots are dropped after the call, move out of them
+    for (size_t i = 0; i < declaration->params.size(); i++) {
+        environment->define(declaration->params[i].first, std::move(arguments[i]));
+    }
+    return environment;
+}
+
 string LoxFunction::toString() {
     return "<fn " + declaration->functionName.lexeme + ">";
 }
 
 shared_ptr<LoxFunction> LoxFunction::bind(shared_ptr<LoxInstance> instance) {
     auto environment = std::make_shared<Environment>(closure);
-    environment->define("this", Object::make_instance_obj(instance));
+    environment->define(thisName(), Object::make_instance_obj(instance));
     return std::make_shared<LoxFunction>(declaration, environment, isInitializer);
 }
\ No newline at end of file
@@ -3,16 +3,16 @@
 #include <string>
 #include <variant>
 
-#include "../../include/BuiltInClass.hpp"
 #include "../../include/LoxClass.hpp"
 #include "../../include/LoxInstance.hpp"
+#include "../../include/NativeFunction.hpp"
 #include "../../include/RuntimeError.hpp"
 #include "../../include/Token.hpp"
 using std::string;
 
-LoxInstance::LoxInstance(LoxClass klass_) : klass(klass_) {}
+LoxInstance::LoxInstance(shared_ptr<LoxClass> klass_) : klass(std::move(klass_)) {}
 
-string LoxInstance::toString() { return klass.name + " instance"; }
+string LoxInstance::toString() { return klass->name + " instance"; }
 
 Object LoxInstance::get(Token name) {
   auto searched = fields.find(name.lexeme);
@@ -20,23 +20,27 @@ Object LoxInstance::get(Token name) {
     return searched->second;
   }
 
-  shared_ptr<LoxFunction> method = klass.findMethod(name.lexeme);
+  shared_ptr<LoxFunction> method = klass->findMethod(name.lexeme);
 
   if (method != nullptr) {
-    // * here you can add class methods about customed builtin class
-    if (auto list_len_method =
-            std::dynamic_pointer_cast<ListLenMethods>(method)) {
-      return Object::make_obj(list_len_method->bind(
-          std::static_pointer_cast<ListInstance>(shared_from_this())));
-    } else if (auto list_append_method =
-                   std::dynamic_pointer_cast<ListAppendMethods>(method)) {
-      return Object::make_obj(list_append_method->bind(
-          std::static_pointer_cast<ListInstance>(shared_from_this())));
-    }
     return Object::make_obj(method->bind(shared_from_this()));
   }
 
+  // methods of builtin classes
+  shared_ptr<NativeMethod> native = klass->findNativeMethod(name.lexeme);
+  if (native != nullptr) {
+    return Object::make_obj(native->bind(shared_from_this()));
+  }
+
   throw RuntimeError(name, "Undefined property '" + name.lexeme + "'.");
 }
 
-void LoxInstance::set(Token name, Object value) { fields[name.lexeme] = value; }
\ No newline at end of file
+void LoxInstance::set(Token name, Object value) { fields[name.lexeme] = value; }
+
+Object LoxInstance::getIndex(const Object &key) {
+  throw RuntimeError("Runtime Error. " + klass->name + " instance can not be subscripted.");
+}
+
+void LoxInstance::setIndex(const Object &key, Object value) {
+  throw RuntimeError("Runtime Error. " + klass->name + " instance can not be subscripted.");
+}
@@ -2,36 +2,57 @@
 #include "../../include/RuntimeError.hpp"
 
 // constrcutor
-LoxList::LoxList() : len{0} {}
+LoxList::LoxList() : storage{std::make_shared<std::vector<Object>>()} {}
 
-LoxList::LoxList(std::vector<Object> values_) : values{std::move(values_)} {
-  len = this->values.size();
+LoxList::LoxList(std::vector<Object> values_)
+    : storage{std::make_shared<std::vector<Object>>(std::move(values_))} {
+  len = storage->size();
 }
 
+LoxList::LoxList(std::shared_ptr<std::vector<Object>> storage_, size_t offset_, size_t len_)
+    : storage{std::move(storage_)}, offset{offset_}, len{len_} {}
+
 /// @brief calculate the list's length
 /// @return length of list
 size_t LoxList::length() const noexcept { return len; }
 
+/// @brief turn an index into a buffer position
+/// @param index index of the list, negative counts from the end
+/// @return position in the storage, throws std::out_of_range
+size_t LoxList::position(int index) const {
+  // * support for minus index
+  long long element = index < 0 ? static_cast<long long>(len) + index : index;
+  if (element < 0 || element >= static_cast<long long>(len)) {
+    throw std::out_of_range("list index out of range");
+  }
+  return offset + static_cast<size_t>(element);
+}
+
+const Object &LoxList::get(int index) const { return (*storage)[position(index)]; }
+
 /// @brief calcualte the slice
 /// @param index index of the list you want
 /// @return
 Object &LoxList::at(int index) {
-  // * support for minus index
-  return index < 0 ? values[len + index] : values[index];
+  size_t element = position(index) - offset;
+  detach();
+  return (*storage)[element];
 }
 
 /// @brief add an element at the end
 /// @param value the value you want to add
 void LoxList::append(const Object &value) {
-  values.push_back(value);
+  detach();
+  storage->push_back(value);
   len += 1;
 }
 
 /// @brief pop the element at the end
 /// @return the end value
 Object LoxList::pop() noexcept {
-  const Object value = values.back();
-  values.pop_back();
+  detach();
+  const Object value = storage->back();
+  storage->pop_back();
   len -= 1;
 
   return value;
@@ -40,11 +61,63 @@ Object LoxList::pop() noexcept {
 /// @brief remove the value at the given index
 /// @param index
 void LoxList::remove(int index) {
-  if (index < 0) {
-    values.erase(values.end() - 1 + index);
-  } else {
-    values.erase(values.begin() + index);
+  size_t element = position(index) - offset;
+  detach();
+  storage->erase(storage->begin() + static_cast<std::ptrdiff_t>(element));
+  len -= 1;
+}
+
+std::vector<Object> LoxList::take() {
+  detach();
+  std::vector<Object> values = std::move(*storage);
+  storage->clear();
+  len = 0;
+  return values;
+}
+
+void LoxList::assign(std::vector<Object> values) {
+  // the old buffer may be shared with slices, never write into it
+  storage = std::make_shared<std::vector<Object>>(std::move(values));
+  offset = 0;
+  len = storage->size();
+}
+
+void LoxList::reverse() {
+  detach();
+  std::reverse(storage->begin(), storage->end());
+}
+
+/// @brief append the elements of other, which may be this list
+void LoxList::extend(const LoxList &other) {
+  if (&other == this) {
+    std::vector<Object> copy(begin(), end());
+    extend(LoxList(std::move(copy)));
+    return;
   }
+  // a list sharing the buffer keeps the old one alive, detach copies ours
+  detach();
+  storage->insert(storage->end(), other.begin(), other.end());
+  len = storage->size();
+}
 
-  len -= 1;
-}
\ No newline at end of file
+std::shared_ptr<LoxList> LoxList::slice(size_t begin, size_t end) const {
+  end = std::min(end, len);
+  begin = std::min(begin, end);
+  return std::shared_ptr<LoxList>(new LoxList(storage, offset + begin, end - begin));
+}
+
+/// @brief make the buffer private to this list and exactly its window, so
+/// it can be written and resized in place
+void LoxList::detach() {
+  if (storage.use_count() == 1 && offset == 0 && len == storage->size()) {
+    return;
+  }
+  if (storage.use_count() == 1) {
+    // the lists sharing it are gone, trim the buffer to this window
+    storage->erase(storage->begin() + static_cast<std::ptrdiff_t>(offset + len), storage->end());
+    storage->erase(storage->begin(), storage->begin() + static_cast<std::ptrdiff_t>(offset));
+  } else {
+    storage = std::make_shared<std::vector<Object>>(begin(), end());
+  }
+  offset = 0;
+}
@@ -0,0 +1,129 @@
+#include "../../include/LoxMap.hpp"
+#include "../../include/LoxString.hpp"
+#include "../../include/RuntimeError.hpp"
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+LoxMap::LoxMap() : index(8, empty) {}
+
+/// @brief numbers are hashed by value, mixed so that consecutive keys do not
+/// land in consecutive slots
+static size_t mix(uint64_t bits) {
+    bits ^= bits >> 33;
+    bits *= 0xff51afd7ed558ccdULL;
+    bits ^= bits >> 33;
+    return static_cast<size_t>(bits);
+}
+
+size_t LoxMap::hashKey(const Object &key) {
+    switch (key.data.index()) {
+        case 0:
+            return std::get<shared_ptr<LoxString>>(key.data)->hash();
+        case 1:
+        case 8: {
+            double number = key.data.index() == 1 ? std::get<double>(key.data) : std::get<int>(key.data);
+            if (std::isnan(number)) {
+                throw RuntimeError("Runtime Error. Map keys can not be nan.");
+            }
+            // 0.0 and -0.0 are the same key
+            number = number == 0 ? 0 : number;
+            uint64_t bits;
+            std::memcpy(&bits, &number, sizeof(bits));
+            return mix(bits);
+        }
+        case 2:
+            return mix(std::get<bool>(key.data) ? 2 : 1);
+        default:
+            throw RuntimeError("Runtime Error. Map keys must be strings, numbers or booleans.");
+    }
+}
+
+bool LoxMap::sameKey(const Object &a, const Object &b) {
+    auto numeric = [](const Object &o) { return o.data.index() == 1 || o.data.index() == 8; };
+    if (numeric(a) && numeric(b)) {
+        double left = a.data.index() == 1 ? std::get<double>(a.data) : std::get<int>(a.data);
+        double right = b.data.index() == 1 ? std::get<double>(b.data) : std::get<int>(b.data);
+        return left == right;
+    }
+    if (a.data.index() != b.data.index()) {
+        return false;
+    }
+    if (a.data.index() == 0) {
+        return std::get<shared_ptr<LoxString>>(a.data)->equals(*std::get<shared_ptr<LoxString>>(b.data));
+    }
+    return std::get<bool>(a.data) == std::get<bool>(b.data);
+}
+
+size_t LoxMap::probe(const Object &key, size_t hash) const {
+    size_t slot = hash & mask();
+    while (index[slot] != empty) {
+        const Entry &entry = entries_[index[slot]];
+        if (entry.hash == hash && sameKey(entry.key, key)) {
+            return slot;
+        }
+        slot = (slot + 1) & mask();
+    }
+    return slot;
+}
+
+Object *LoxMap::find(const Object &key) {
+    int32_t found = index[probe(key, hashKey(key))];
+    return found == empty ? nullptr : &entries_[found].value;
+}
+
+void LoxMap::set(const Object &key, Object value) {
+    size_t hash = hashKey(key);
+    size_t slot = probe(key, hash);
+    if (index[slot] != empty) {
+        entries_[index[slot]].value = std::move(value);
+        return;
+    }
+    index[slot] = static_cast<int32_t>(entries_.size());
+    entries_.push_back({hash, key, std::move(value)});
+    // keep the index at most 3/4 full
+    if (entries_.size() * 4 > index.size() * 3) {
+        grow();
+    }
+}
+
+bool LoxMap::remove(const Object &key) {
+    size_t slot = probe(key, hashKey(key));
+    int32_t removed = index[slot];
+    if (removed == empty) {
+        return false;
+    }
+
+    // backward-shift the entries of the probe run that follows the hole
+    size_t hole = slot;
+    for (size_t next = (hole + 1) & mask(); index[next] != empty; next = (next + 1) & mask()) {
+        size_t home = entries_[index[next]].hash & mask();
+        // move it unless its home slot lies cyclically in (hole, next]
+        bool between = hole <= next ? (hole < home && home <= next) : (hole < home || home <= next);
+        if (!between) {
+            index[hole] = index[next];
+            hole = next;
+        }
+    }
+    index[hole] = empty;
+
+    // fill the gap in the entries with the last entry
+    auto last = static_cast<int32_t>(entries_.size() - 1);
+    if (removed != last) {
+        index[probe(entries_[last].key, entries_[last].hash)] = removed;
+        entries_[removed] = std::move(entries_[last]);
+    }
+    entries_.pop_back();
+    return true;
+}
+
+void LoxMap::grow() {
+    index.assign(index.size() * 2, empty);
+    for (size_t i = 0; i < entries_.size(); i++) {
+        size_t slot = entries_[i].hash & mask();
+        while (index[slot] != empty) {
+            slot = (slot + 1) & mask();
+        }
+        index[slot] = static_cast<int32_t>(i);
+    }
+}
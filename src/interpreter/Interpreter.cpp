@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <memory>
 #include <stdexcept>
@@ -6,11 +8,12 @@
 #include <variant>
 #include <vector>
 
+#include "../../include/BuiltInAsync.hpp"
 #include "../../include/BuiltInClass.hpp"
-#include "../../include/BuiltInFun.hpp"
 #include "../../include/BuiltInIo.hpp"
 #include "../../include/Environment.hpp"
 #include "../../include/Expr.hpp"
+#include "../../include/Generator.hpp"
 #include "../../include/Interpreter.hpp"
 #include "../../include/Logger.hpp"
 #include "../../include/LoxCallable.hpp"
@@ -18,8 +21,12 @@
 #include "../../include/LoxFunction.hpp"
 #include "../../include/LoxInstance.hpp"
 #include "../../include/LoxList.hpp"
+#include "../../include/LoxString.hpp"
+#include "../../include/NativeFunction.hpp"
+#include "../../include/Profile.hpp"
 #include "../../include/RuntimeError.hpp"
 #include "../../include/RuntimeException.hpp"
+#include "../../include/TypedArray.hpp"
 #include "../../include/Stmt.hpp"
 #include "../../include/lox.hpp"
 
@@ -35,15 +42,18 @@ bool endsWith(std::string str, std::string suffix) {
     return str.substr(str.length() - suffix.length()) == suffix;
 }
 
-Interpreter::Interpreter()//: global_environment{globals.get()}
-{
+Interpreter::Interpreter(RunContext &context) : context(context) {
     // native function
-    globals->define("clock", Object::make_obj(std::make_shared<ClockCallable>()));
-    globals->define("print", Object::make_obj(std::make_shared<PrintCallable>()));
-    globals->define("type", Object::make_obj(std::make_shared<TypeCallable>()));
-    globals->define("input", Object::make_obj(std::make_shared<InputCallable>()));
+    defineNatives(*globals);
     // native class
-    globals->define("list", Object::make_class_obj(std::make_shared<ListClass>()));
+    listClass = std::make_shared<ListClass>();
+    mapClass = std::make_shared<MapClass>();
+    globals->define("list", Object::make_class_obj(listClass));
+    globals->define("StringBuilder", Object::make_class_obj(std::make_shared<StringBuilderClass>()));
+    globals->define("map", Object::make_class_obj(mapClass));
+    globals->define("dict", Object::make_class_obj(mapClass));
+    globals->define("Float64Array", Object::make_class_obj(std::make_shared<Float64ArrayClass>("Float64Array")));
+    globals->define("Int64Array", Object::make_class_obj(std::make_shared<Int64ArrayClass>("Int64Array")));
 
     // environment = globals;
 }
@@ -51,17 +61,38 @@ Interpreter::Interpreter()//: global_environment{globals.get()}
 /// @brief interpret the list of statements
 /// @param statements statements sequence that are generatede by the parser
 void Interpreter::interpret(vector<shared_ptr<Stmt>> statements) {
+    program = statements;
     try {
         for (auto statement: statements) {
             execute(statement);
         }
+        // then whatever the statements started asynchronously
+        if (events != nullptr) {
+            events->run();
+        }
     } catch (const RuntimeError &error) {
-        Error::addRuntimeError(error);
+        context.errors.addRuntimeError(error);
         // lox::runtimeError(error);
     } catch (const ReturnError &) {
         //...
     }
 }
+/// @brief an interpreter that runs the same resolved program with globals of
+/// its own: the natives and the program's top-level functions and classes,
+/// but none of its global variables
+shared_ptr<Interpreter> Interpreter::isolate(RunContext &isolateContext) {
+    auto copy = std::make_shared<Interpreter>(isolateContext);
+    // the syntax tree is never changed after resolving, isolates share it
+    copy->locals = locals;
+    copy->program = program;
+    for (auto &statement: program) {
+        if (statement->type == StmtType::Function || statement->type == StmtType::Class) {
+            copy->execute(statement);
+        }
+    }
+    return copy;
+}
+
 // runner function
 Object Interpreter::evaluate(shared_ptr<Expr<Object>> expr) {
     return expr->accept(shared_from_this());
@@ -112,7 +143,7 @@ bool Interpreter::isTruthy(Object object) {
     return true;
 }
 
-bool Interpreter::isEqual(Object a, Object b) {
+bool Interpreter::isEqual(const Object &a, const Object &b) {
     if (a.data.index() == 3 && b.data.index() == 3) {
         return true;
     }
@@ -122,7 +153,8 @@ bool Interpreter::isEqual(Object a, Object b) {
     if (a.data.index() == b.data.index()) {
         switch (a.data.index()) {
             case 0:
-                return std::get<std::string>(a.data) == std::get<std::string>(b.data);
+                // a pointer compare when both are interned
+                return std::get<shared_ptr<LoxString>>(a.data)->equals(*std::get<shared_ptr<LoxString>>(b.data));
             case 1:
                 return std::get<double>(a.data) == std::get<double>(b.data);
             case 2:
@@ -153,9 +185,9 @@ void Interpreter::checkNumberOperands(Token operation, Object left, Object right
 }
 
 Object Interpreter::lookUpVariable(Token name, shared_ptr<Expr<Object>> expr) {
-    if (locals.find(expr) != locals.end()) {
-        auto distance = locals.at(expr);
-        return environment->getAt(distance, name.lexeme);
+    auto distance = locals.find(expr);
+    if (distance != locals.end()) {
+        return environment->getAt(distance->second, name.name());
     }
     return globals->get(name);
 }
@@ -172,7 +204,8 @@ Object Interpreter::visitLiteralExpr(shared_ptr<Literal<Object>> expr) {
             return Object::make_obj(std::get<int>(expr->value.data));
 
         default:
-            return Object::make_obj(std::get<std::string>(expr->value.data));
+            // shares the interned literal
+            return expr->value;
     }
 }
 
@@ -243,8 +276,11 @@ Object Interpreter::visitBinaryExpr(shared_ptr<Binary<Object>> expr) {
             }
             // left.type == Object::Object_str && right.type == Object::Object_str
             if (left.data.index() == 0 && right.data.index() == 0) {
-                result_str = left.toString() + right.toString();
-                return Object::make_obj(result_str);
+                const auto &leftStr = std::get<shared_ptr<LoxString>>(left.data)->str();
+                const auto &rightStr = std::get<shared_ptr<LoxString>>(right.data)->str();
+                result_str.reserve(leftStr.size() + rightStr.size());
+                result_str.append(leftStr).append(rightStr);
+                return Object::make_obj(std::move(result_str));
             }
             throw RuntimeError(
                 expr->operation,
@@ -351,13 +387,59 @@ Object Interpreter::visitDecrementExpr(shared_ptr<Decrement<Object>> expr) {
 /// @param expr list expression
 /// @return
 Object Interpreter::visitListExpr(shared_ptr<List<Object>> expr) {
-    auto list = std::make_shared<LoxList>();
+    vector<Object> values;
+    values.reserve(expr->items.size());
     // evaluate the each element in the list
     for (const auto &item: expr->items) {
         assert(item);
-        list->append(evaluate(item));
+        values.push_back(evaluate(item));
+    }
+    return Object::make_obj(std::make_shared<LoxList>(std::move(values)));
+}
+
+/// @brief evaluate a[i:j], a list sharing the elements of a until either is written
+/// @param target the subscripted value, a list or a list() instance
+/// @param expr subscript expression
+/// @return
+Object Interpreter::evaluateSlice(const Object &target, shared_ptr<Subscript<Object>> expr) {
+    shared_ptr<LoxList> list;
+    if (std::holds_alternative<shared_ptr<LoxList>>(target.data)) {
+        list = std::get<shared_ptr<LoxList>>(target.data);
+    } else if (std::holds_alternative<shared_ptr<LoxInstance>>(target.data)) {
+        if (auto instance = dynamic_cast<ListInstance *>(std::get<shared_ptr<LoxInstance>>(target.data).get())) {
+            list = std::get<shared_ptr<LoxList>>(instance->fields["value"].data);
+        }
+    }
+    if (list == nullptr) {
+        throw RuntimeError(expr->identifier, "Runtime Error. Object " + expr->identifier.lexeme + " can not be sliced.");
+    }
+    size_t length = list->length();
+    size_t begin = sliceBound(expr->index, 0, length, expr->identifier);
+    size_t end = sliceBound(expr->end, length, length, expr->identifier);
+    return Object::make_obj(list->slice(begin, end));
+}
+
+/// @brief a slice bound clamped to [0, length], negative bounds count from the end
+/// @param bound bound expression, null when it is left out
+/// @param missing the value of a left out bound
+size_t Interpreter::sliceBound(shared_ptr<Expr<Object>> bound, size_t missing, size_t length, const Token &name) {
+    if (bound == nullptr) {
+        return missing;
+    }
+    Object value = evaluate(bound);
+    double position = 0;
+    if (std::holds_alternative<int>(value.data)) {
+        position = std::get<int>(value.data);
+    } else if (std::holds_alternative<double>(value.data) &&
+               std::floor(std::get<double>(value.data)) == std::get<double>(value.data)) {
+        position = std::get<double>(value.data);
+    } else {
+        throw RuntimeError(name, "Runtime Error. Indices must be integers.");
+    }
+    if (position < 0) {
+        position += static_cast<double>(length);
     }
-    return Object::make_obj(list);
+    return static_cast<size_t>(std::clamp(position, 0.0, static_cast<double>(length)));
 }
 
 /// @brief visit a subscript expression, call a list, like a[]
@@ -366,6 +448,27 @@ Object Interpreter::visitListExpr(shared_ptr<List<Object>> expr) {
 Object Interpreter::visitSubscriptExpr(shared_ptr<Subscript<Object>> expr) {
     // get the pointer to the list associated with the identifier
     Object iden_ptr = lookUpVariable(expr->identifier, expr);
+    if (expr->slice) {
+        return evaluateSlice(iden_ptr, expr);
+    }
+    // instances of native classes such as map handle subscripts themselves
+    if (iden_ptr.data.index() == 6) {
+        auto instance = std::get<shared_ptr<LoxInstance>>(iden_ptr.data);
+        Object key = evaluate(expr->index);
+        try {
+            if (expr->value) {
+                Object value = evaluate(expr->value);
+                instance->setIndex(key, value);
+                return value;
+            }
+            return instance->getIndex(key);
+        } catch (RuntimeError &error) {
+            if (error.token.line == -1) {
+                error.token = expr->identifier;
+            }
+            throw;
+        }
+    }
     // check if the identifier is a list, if not, throw an error
     // iden_ptr.type != Object::Object_type::Object_list
     if (iden_ptr.data.index() != 4) {
@@ -386,30 +489,33 @@ Object Interpreter::visitSubscriptExpr(shared_ptr<Subscript<Object>> expr) {
     // index.type == Object::Object_type::Object_num
     if (index.data.index() == 1) {
         index_cast = std::get<double>(index.data);
+    } else if (index.data.index() == 8) {
+        index_cast = std::get<int>(index.data);
     } else {
         throw RuntimeError(expr->identifier, "Runtime Error. Indices must be integers.");
     }
-    // Throw an error if index is not an integer.
-    if (static_cast<int>(index_cast) != index_cast) {
+    // Throw an error if index is not an integer, NaN included.
+    if (index_cast != std::floor(index_cast)) {
         throw RuntimeError(expr->identifier, "Runtime Error. Indices must be integers.");
     }
 
+    // Range check in double, the index may not fit any integer type.
+    object_size = list->length();
+    double position = index_cast < 0 ? index_cast + static_cast<double>(object_size) : index_cast;
     try {
-        object_size = list->length();
-
-        // ? something superfluous, beacuse "at" has allowed this manner
-        if (index_cast < 0)// allow this manner
-        {
-            index_cast = static_cast<int>(list->length()) + index_cast;
+        if (position < 0 || position >= static_cast<double>(object_size)) {
+            throw std::out_of_range("index");
         }
         // If value is associated with the subscript expression, new value will be
         // assigned to the corresponding index.
         if (expr->value) {
-            list->at(index_cast) = evaluate(expr->value);
+            list->at(static_cast<int>(position)) = evaluate(expr->value);
         }
-        return list->at(index_cast);
+        return list->get(static_cast<int>(position));
     } catch (const std::out_of_range &e) {
-        throw RuntimeError(expr->identifier, "RunTime Error. Index out of range. Index is " + to_string(static_cast<int>(index_cast)) + " but object size is " + to_string(object_size));
+        string shown;
+        ::stringify(index, shown);
+        throw RuntimeError(expr->identifier, "RunTime Error. Index out of range. Index is " + shown + " but object size is " + to_string(list->length()));
     }
 }
 
@@ -423,64 +529,115 @@ Object Interpreter::visitVariableExpr(shared_ptr<Variable<Object>> expr) {
     return lookUpVariable(expr->name, expr);
 }
 
+namespace {
+    // drops the list a view was lent for once the call is over, unless the
+    // method kept the view, so the cache never keeps a large list alive
+    struct ListViewLease {
+        shared_ptr<ListInstance> view;
+        ~ListViewLease() {
+            if (view != nullptr && view.use_count() == 2) {
+                view->fields["value"] = Object::make_nil_obj();
+            }
+        }
+    };
+}
+
 Object Interpreter::visitCallExpr(shared_ptr<Call<Object>> expr) {
-    // search the callee in the environment and return it(function, class,
-    // instance)
-    Object callee = evaluate(expr->callee);
+    // xs.method(...) on a list literal calls the list() method on a view of xs
+    // directly, without binding a new method object for the call
+    shared_ptr<NativeMethod> listMethod;
+    ListViewLease lease;
+    Object callee;
+    if (expr->callee->type == ExprType::Get) {
+        auto get = std::static_pointer_cast<Get<Object>>(expr->callee);
+        Object object = evaluate(get->object);
+        if (object.data.index() == 4) {
+            listMethod = listClass->findNativeMethod(get->name.lexeme);
+        }
+        if (listMethod != nullptr) {
+            lease.view = listView(std::get<shared_ptr<LoxList>>(object.data));
+        } else {
+            callee = propertyOf(object, get->name);
+        }
+    } else {
+        // search the callee in the environment and return it(function, class,
+        // instance)
+        callee = evaluate(expr->callee);
+    }
+    // a body recursing too deep would run into the guard page of its stack
+    if (generator != nullptr && generator->stackExhausted()) {
+        throw RuntimeError(expr->paren, "Runtime Error. Stack overflow in a generator, its calls nest too deep.");
+    }
 
-    vector<Object> arguments;
-    arguments.reserve(expr->arguments.size());
-    for (auto argument: expr->arguments) {
-        arguments.push_back(evaluate(argument));
+    // a generator brings its own stack, its frames interleave with the caller's
+    vector<Object> &stack = *argumentStack;
+    ArgumentFrame frame(stack);
+    for (const auto &argument: expr->arguments) {
+        stack.push_back(evaluate(argument));
     }
+    Arguments arguments(stack, frame.base, expr->arguments.size());
     // callee.type != Object::Object_fun &&callee.type !=
     // Object::Object_class
 
-    if (callee.data.index() != 5 && callee.data.index() != 7) {
-        throw RuntimeError(expr->paren, "Runtime Error. Can only call functions and classes.");
-    }
-
     shared_ptr<LoxCallable> callable;
-
-    if (std::holds_alternative<shared_ptr<LoxCallable>>(
-            callee.data
-        )) {// callee.type == Object::Object_fun
+    if (listMethod != nullptr) {
+        callable = listMethod;
+    } else if (callee.data.index() == 5) {// callee.type == Object::Object_fun
         callable = std::get<shared_ptr<LoxCallable>>(callee.data);
-        auto func = std::get<shared_ptr<LoxCallable>>(callee.data).get();
-        if (dynamic_cast<PrintCallable *>(std::move(func))) {
-            callable = std::make_shared<PrintCallable>(arguments.size());
-        } else if (dynamic_cast<ClockCallable *>(std::move(func))) {
-            callable = std::make_shared<ClockCallable>();
-        } else if (dynamic_cast<TypeCallable *>(std::move(func))) {
-            callable = std::make_shared<TypeCallable>(arguments.size());
-        } else if (dynamic_cast<InputCallable *>(std::move(func))) {
-            callable = std::make_shared<InputCallable>();
-        }
-        if (auto ptr_list_len = dynamic_cast<ListLenMethods *>(std::move(func))) {
-            return ptr_list_len->call(shared_from_this(), arguments);
-        }
-    }
-    // callee.type == Object::Object_class
-    if (callee.data.index() == 7) {
+    } else if (callee.data.index() == 7) {// callee.type == Object::Object_class
         callable = std::get<shared_ptr<LoxClass>>(callee.data);
-        if (dynamic_cast<ListClass *>(callable.get())) {
-            return callable->call(shared_from_this(), arguments);
-        }
+    } else {
+        throw RuntimeError(expr->paren, "Runtime Error. Can only call functions and classes.");
+    }
+    size_t arity = callable->arity();
+    if (arity != LoxCallable::VARIADIC && arguments.size() != arity) {
+        throw RuntimeError(expr->paren, "Runtime Error. Expected " + to_string(arity) + " arguments but got " + to_string(arguments.size()) + ".");
+    }
+    if (profile != nullptr) {
+        auto function = dynamic_cast<LoxFunction *>(callable.get());
+        profile->call(expr->nodeId, function != nullptr ? function->declaration->nodeId : 0);
     }
-    if (arguments.size() != callable->arity()) {
-        throw RuntimeError(expr->paren, "Runtime Error. Expected " + to_string(callable->arity()) + " arguments but got " + to_string(arguments.size()) + ".");
+    try {
+        callSite = &expr->paren;
+        if (listMethod != nullptr) {
+            return listMethod->callOn(*this, *lease.view, arguments);
+        }
+        return callable->call(*this, arguments);
+    } catch (RuntimeError &error) {
+        // natives raise errors without a token, report them at the call
+        if (error.token.line == -1) {
+            error.token = expr->paren;
+        }
+        throw;
     }
-    return callable->call(shared_from_this(), arguments);
 }
 
 Object Interpreter::visitGetExpr(shared_ptr<Get<Object>> expr) {
-    Object object = evaluate(expr->object);
+    return propertyOf(evaluate(expr->object), expr->name);
+}
+
+Object Interpreter::propertyOf(const Object &object, const Token &name) {
     // object.type == Object::Object_instance
     if (object.data.index() == 6) {
-        return std::get<shared_ptr<LoxInstance>>(object.data)->get(expr->name);
+        return std::get<shared_ptr<LoxInstance>>(object.data)->get(name);
     }
+    // list literals have the methods of list(), bound to a view of the same elements
+    if (object.data.index() == 4) {
+        return listView(std::get<shared_ptr<LoxList>>(object.data))->get(name);
+    }
+
+    throw RuntimeError(name, "Runtime Error. Only instances have properties.");
+}
 
-    throw RuntimeError(expr->name, "Runtime Error. Only instances have properties.");
+shared_ptr<ListInstance> Interpreter::listView(const shared_ptr<LoxList> &list) {
+    // reuse the last view unless something still holds it, a bound method
+    // or a call that is still running
+    if (cachedListView == nullptr || cachedListView.use_count() != 1) {
+        cachedListView = std::make_shared<ListInstance>(listClass, list);
+    } else {
+        cachedListView->fields["value"] = Object::make_obj(list);
+    }
+    return cachedListView;
 }
 
 Object Interpreter::visitSetExpr(shared_ptr<Set<Object>> expr) {
@@ -501,10 +658,11 @@ Object Interpreter::visitThisExpr(shared_ptr<This<Object>> expr) {
 
 Object Interpreter::visitSuperExpr(shared_ptr<Super<Object>> expr) {
     int distance = locals[expr];
-    Object superclass = environment->getAt(distance, "super");
+    Object superclass = environment->getAt(distance, expr->keyword.name());
 
     // "this" is always one level nearer than "super"'s environment.
-    Object instance = environment->getAt(distance - 1, "this");
+    static const LoxString *thisName = LoxString::intern("this").get();
+    Object instance = environment->getAt(distance - 1, thisName);
 
     shared_ptr<LoxFunction> method =
         std::get<shared_ptr<LoxClass>>(superclass.data)
@@ -519,6 +677,13 @@ Object Interpreter::visitSuperExpr(shared_ptr<Super<Object>> expr) {
     return Object::make_obj(binded_method);
 }
 
+Object Interpreter::visitYieldExpr(shared_ptr<Yield<Object>> expr) {
+    Object value = expr->value != nullptr ? evaluate(expr->value) : Object::make_nil_obj();
+    // the resolver only lets yield appear in function bodies, which makes
+    // them generators, so one is always running here
+    return generator->yield(std::move(value));
+}
+
 void Interpreter::visitExpressionStmt(const Expression &stmt) {
     evaluate(stmt.expression);
 }
@@ -548,7 +713,7 @@ void Interpreter::visitVarStmt(const Var &stmt) {
     if (stmt.initializer != nullptr) {
         value = evaluate(stmt.initializer);
     }
-    environment->define(stmt.name.lexeme, value);
+    environment->define(stmt.name, std::move(value));
 }
 
 void Interpreter::visitBlockStmt(const Block &stmt) {
@@ -566,7 +731,7 @@ void Interpreter::visitClassStmt(const Class &stmt) {
         }
     }
 
-    environment->define(stmt.name.lexeme, Object::make_nil_obj());
+    environment->define(stmt.name, Object::make_nil_obj());
 
     if (stmt.superclass != nullptr) {
         environment = std::make_shared<Environment>(environment);
@@ -598,7 +763,14 @@ void Interpreter::visitClassStmt(const Class &stmt) {
 }
 
 void Interpreter::visitWhileStmt(const While &stmt) {
-    while (isTruthy(evaluate(stmt.condition))) {
+    while (true) {
+        bool taken = isTruthy(evaluate(stmt.condition));
+        if (profile != nullptr) {
+            profile->branch(stmt.nodeId, taken);
+        }
+        if (!taken) {
+            break;
+        }
         try {
             execute(stmt.body);
         }
@@ -616,7 +788,11 @@ void Interpreter::visitWhileStmt(const While &stmt) {
 
 void Interpreter::visitIfStmt(const If &stmt) {
     // ! it cannot interprete nested if-else expression
-    if (isTruthy(evaluate(stmt.main_branch.condition))) {
+    bool taken = isTruthy(evaluate(stmt.main_branch.condition));
+    if (profile != nullptr) {
+        profile->branch(stmt.nodeId, taken);
+    }
+    if (taken) {
         execute(stmt.main_branch.statement);
     }
     for (auto &else_if: stmt.elif_branches) {
@@ -633,7 +809,7 @@ void Interpreter::visitFunctionStmt(shared_ptr<Function> stmt) {
     shared_ptr<LoxFunction> function =
         std::make_shared<LoxFunction>(stmt, environment, false);
     Object obj = Object::make_obj(function);
-    environment->define(stmt->functionName.lexeme, obj);
+    environment->define(stmt->functionName, obj);
 }
 
 // The EnvironmentGuard class is used to manage the interpreter's environment
@@ -653,3 +829,10 @@ Interpreter::EnvironmentGuard::EnvironmentGuard(
 Interpreter::EnvironmentGuard::~EnvironmentGuard() {
     interpreter.environment = std::move(previous_env);
 }
+
+Interpreter::ArgumentFrame::ArgumentFrame(vector<Object> &stack)
+    : base{stack.size()}, stack{stack} {}
+
+Interpreter::ArgumentFrame::~ArgumentFrame() {
+    stack.resize(base);
+}
@@ -50,7 +50,7 @@ Object Resolver::visitVariableExpr(shared_ptr<Variable<Object>> expr) {
         auto last = scopes.back();
         auto searched = last.find(expr->name.lexeme);
         if (searched != last.end() && !searched->second) {
-            Error::addError(expr->name, "Resolvetime Error. Can't read local "
+            interpreter->context.errors.addError(expr->name, "Resolvetime Error. Can't read local "
                                         "variable in its own initializer.");
             // lox::error(expr->name.line,
             //            "Resolvetime Error. Cannot read local variable in its own
@@ -85,8 +85,13 @@ Object Resolver::visitListExpr(shared_ptr<List<Object>> expr) {
 }
 
 Object Resolver::visitSubscriptExpr(shared_ptr<Subscript<Object>> expr) {
-    // Resolve the index of the subscript.
-    resolve(expr->index);
+    // Resolve the index of the subscript, slice bounds may be left out.
+    if (expr->index) {
+        resolve(expr->index);
+    }
+    if (expr->end) {
+        resolve(expr->end);
+    }
     // If there's a value associated with the subscript, then it is also resolved.
     if (expr->value) {
         resolve(expr->value);
@@ -125,7 +130,7 @@ Object Resolver::visitSetExpr(shared_ptr<Set<Object>> expr) {
 
 Object Resolver::visitThisExpr(shared_ptr<This<Object>> expr) {
     if (currentClass == CLASS_NONE) {
-        Error::addError(expr->keyword, "Resolvetime Error. Cannot use 'this' outside of a class.");
+        interpreter->context.errors.addError(expr->keyword, "Resolvetime Error. Cannot use 'this' outside of a class.");
         // lox::error(expr->keyword.line,
         //            "Resolvetime Error. Cannot use 'this' outside of a class.");
         return Object::make_nil_obj();
@@ -136,14 +141,14 @@ Object Resolver::visitThisExpr(shared_ptr<This<Object>> expr) {
 
 Object Resolver::visitSuperExpr(shared_ptr<Super<Object>> expr) {
     if (currentClass == CLASS_NONE) {
-        Error::addError(
+        interpreter->context.errors.addError(
             expr->keyword,
             "Resolvetime Error. Cannot use 'super' outside of a class."
         );
         // lox::error(expr->keyword.line,
         //            "Resolvetime Error. Cannot use 'super' outside of a class.");
     } else if (currentClass != SUBCLASS) {
-        Error::addError(
+        interpreter->context.errors.addError(
             expr->keyword,
             "Resolvetime Error. Cannot use 'super' in a class with no superclass."
         );
@@ -155,6 +160,18 @@ Object Resolver::visitSuperExpr(shared_ptr<Super<Object>> expr) {
     return Object::make_nil_obj();
 }
 
+Object Resolver::visitYieldExpr(shared_ptr<Yield<Object>> expr) {
+    if (currentFunction == FUNCTION_NONE) {
+        interpreter->context.errors.addError(expr->keyword, "Resolvetime Error. Cannot yield from top-level code.");
+    } else if (currentFunction == INITIALIZER) {
+        interpreter->context.errors.addError(expr->keyword, "Resolvetime Error. Cannot yield from an initializer.");
+    }
+    if (expr->value != nullptr) {
+        resolve(expr->value);
+    }
+    return Object::make_nil_obj();
+}
+
 void Resolver::visitExpressionStmt(const Expression &stmt) {
     resolve(stmt.expression);
 }
@@ -184,7 +201,7 @@ void Resolver::visitClassStmt(const Class &stmt) {
 
     if (stmt.superclass != nullptr &&
         stmt.name.lexeme == stmt.superclass->name.lexeme) {
-        Error::addError(stmt.superclass->name, "Resolvetime Error. A class cannot inherit from itself.");
+        interpreter->context.errors.addError(stmt.superclass->name, "Resolvetime Error. A class cannot inherit from itself.");
         // lox::error(stmt.superclass->name.line,
         //            "Resolvetime Error. A class cannot inherit from itself.");
     }
@@ -251,14 +268,14 @@ void Resolver::visitFunctionStmt(shared_ptr<Function> stmt) {
 
 void Resolver::visitReturnStmt(const Return &stmt) {
     if (currentFunction == FUNCTION_NONE) {
-        Error::addError(stmt.name, "Resolvetime Error. Cannot return from top-level code.");
+        interpreter->context.errors.addError(stmt.name, "Resolvetime Error. Cannot return from top-level code.");
         // lox::error(stmt.name.line, "Resolvetime Error. Cannot return from
         // top-level code.");
     }
 
     if (stmt.value != nullptr) {
         if (currentFunction == INITIALIZER) {
-            Error::addError(
+            interpreter->context.errors.addError(
                 stmt.name,
                 "Resolvetime Error. Cannot return a value from an initializer."
             );
@@ -273,7 +290,7 @@ void Resolver::visitReturnStmt(const Return &stmt) {
 void Resolver::visitBreakStmt(const Break &stmt) {
     // If not in a nested loop, add a new error.
     if (loop_nesting_level == 0) {
-        Error::addError(stmt.keyword, "Resolvetime Error. Can't break outside of a loop.");
+        interpreter->context.errors.addError(stmt.keyword, "Resolvetime Error. Can't break outside of a loop.");
         // lox::error(stmt.keyword.line, "Resolvetime Error. Can't break outside of
         // a loop.");
     }
@@ -282,7 +299,7 @@ void Resolver::visitBreakStmt(const Break &stmt) {
 void Resolver::visitContinueStmt(const Continue &stmt) {
     // If not in a nested loop, add a new error.
     if (loop_nesting_level == 0) {
-        Error::addError(stmt.keyword, "Resolvetime Error. Can't break outside of a loop.");
+        interpreter->context.errors.addError(stmt.keyword, "Resolvetime Error. Can't break outside of a loop.");
         // lox::error(stmt.keyword.line, "Resolvetime Error. Can't break outside of
         // a loop.");
     }
@@ -314,7 +331,7 @@ void Resolver::declare(Token name) {
         return;
     map<string, bool> scope = scopes.back();
     if (scope.find(name.lexeme) != scope.end()) {
-        Error::addError(name, "Resolvetime Error. Variable with the name '" + name.lexeme + "' already exists in this scope");
+        interpreter->context.errors.addError(name, "Resolvetime Error. Variable with the name '" + name.lexeme + "' already exists in this scope");
         // lox::error(name.line,
         //            "Resolvetime Error. Variable with this name already declared
         //            in this scope.");
@@ -66,6 +66,8 @@ Object CodeGenerator::visitThisExpr(shared_ptr<This<Object>> expr) { return Obje
 
 Object CodeGenerator::visitSuperExpr(shared_ptr<Super<Object>> expr) { return Object::make_nil_obj(); }
 
+Object CodeGenerator::visitYieldExpr(shared_ptr<Yield<Object>> expr) { return Object::make_nil_obj(); }
+
 void CodeGenerator::visitExpressionStmt(const Expression &stmt) {
     codegenerate(stmt.expression);
 }
@@ -0,0 +1,145 @@
+#include "../../include/LoxJIT.hpp"
+#include "../../include/Logger.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/ExecutionEngine/Orc/RTDyldObjectLinkingLayer.h>
+#include <llvm/ExecutionEngine/SectionMemoryManager.h>
+#include <llvm/Object/SymbolSize.h>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/TargetSelect.h>
+
+LoxJIT::LoxJIT(std::string script) : script(std::move(script)) {
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+}
+
+/// @brief compile the module to native code and call its main
+/// @return the exit status returned by main
+int LoxJIT::run(std::unique_ptr<llvm::Module> module, std::unique_ptr<llvm::LLVMContext> ctx) {
+    auto perf = std::getenv("LOX_PERF");
+    std::string mode = perf != nullptr ? perf : "";
+    bool perfMap = !mode.empty() && mode != "jitdump";
+    bool jitdump = !mode.empty() && mode != "map";
+
+    // keep frame pointers so perf can unwind through Lox frames
+    if (!mode.empty()) {
+        for (auto &fn: *module) {
+            if (!fn.isDeclaration()) {
+                fn.addFnAttr("frame-pointer", "all");
+            }
+        }
+    }
+
+    std::unique_ptr<PerfMapListener> mapListener;
+    if (perfMap) {
+        mapListener = std::make_unique<PerfMapListener>(sourceNames(*module));
+    }
+    llvm::JITEventListener *perfListener = nullptr;
+    if (jitdump) {
+        perfListener = llvm::JITEventListener::createPerfJITEventListener();
+        if (perfListener == nullptr) {
+            llvm::errs() << "[LoxJIT]: LLVM is built without perf support, no jitdump written\n";
+        }
+    }
+
+    auto jit = llvm::orc::LLJITBuilder()
+                       .setObjectLinkingLayerCreator([&](llvm::orc::ExecutionSession &session, const llvm::Triple &)
+                                                             -> llvm::Expected<std::unique_ptr<llvm::orc::ObjectLayer>> {
+                           auto layer = std::make_unique<llvm::orc::RTDyldObjectLinkingLayer>(session, [] {
+                               return std::make_unique<llvm::SectionMemoryManager>();
+                           });
+                           if (mapListener != nullptr) {
+                               layer->registerJITEventListener(*mapListener);
+                           }
+                           if (perfListener != nullptr) {
+                               layer->registerJITEventListener(*perfListener);
+                           }
+                           return layer;
+                       })
+                       .create();
+    if (!jit) {
+        Error::ErrorLogMessage() << "[LoxJIT]: " << llvm::toString(jit.takeError());
+    }
+
+    // printf and the runtime library resolve against the host executable
+    auto host = llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess((*jit)->getDataLayout().getGlobalPrefix());
+    if (!host) {
+        Error::ErrorLogMessage() << "[LoxJIT]: " << llvm::toString(host.takeError());
+    }
+    (*jit)->getMainJITDylib().addGenerator(std::move(*host));
+
+    if (auto err = (*jit)->addIRModule(llvm::orc::ThreadSafeModule(std::move(module), std::move(ctx)))) {
+        Error::ErrorLogMessage() << "[LoxJIT]: " << llvm::toString(std::move(err));
+    }
+    auto mainSymbol = (*jit)->lookup("main");
+    if (!mainSymbol) {
+        Error::ErrorLogMessage() << "[LoxJIT]: " << llvm::toString(mainSymbol.takeError());
+    }
+    auto mainFn = llvm::jitTargetAddressToFunction<int (*)()>(mainSymbol->getAddress());
+    int status = mainFn();
+    std::fflush(stdout);
+    return status;
+}
+
+/// @brief map symbol names to Lox names with the source location
+std::map<std::string, std::string> LoxJIT::sourceNames(const llvm::Module &module) const {
+    std::map<std::string, std::string> names;
+    for (auto &fn: module) {
+        if (fn.isDeclaration()) {
+            continue;
+        }
+        auto name = fn.getName().str();
+        if (fn.hasFnAttribute(lineAttribute)) {
+            auto line = fn.getFnAttribute(lineAttribute).getValueAsString().str();
+            names[name] = name + " (" + script + ":" + line + ")";
+        } else if (name == "main") {
+            names[name] = "main (" + script + ")";
+        }
+    }
+    return names;
+}
+
+PerfMapListener::PerfMapListener(std::map<std::string, std::string> names) : names(std::move(names)) {
+    auto path = "/tmp/perf-" + std::to_string(getpid()) + ".map";
+    std::error_code errorCode;
+    out = std::make_unique<llvm::raw_fd_ostream>(path, errorCode, llvm::sys::fs::OF_Append);
+    if (errorCode) {
+        llvm::errs() << "[LoxJIT]: cannot write " << path << ": " << errorCode.message() << "\n";
+        out.reset();
+    }
+}
+
+void PerfMapListener::notifyObjectLoaded(ObjectKey key, const llvm::object::ObjectFile &obj,
+                                         const llvm::RuntimeDyld::LoadedObjectInfo &info) {
+    // the debug object carries the final load addresses
+    auto debugObj = info.getObjectForDebug(obj);
+    if (out == nullptr || debugObj.getBinary() == nullptr) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto &[symbol, size]: llvm::object::computeSymbolSizes(*debugObj.getBinary())) {
+        auto type = symbol.getType();
+        if (!type) {
+            llvm::consumeError(type.takeError());
+            continue;
+        }
+        if (*type != llvm::object::SymbolRef::ST_Function) {
+            continue;
+        }
+        auto name = symbol.getName();
+        auto address = symbol.getAddress();
+        if (!name || !address) {
+            llvm::consumeError(name.takeError());
+            llvm::consumeError(address.takeError());
+            continue;
+        }
+        auto found = names.find(name->str());
+        auto display = found != names.end() ? found->second : name->str();
+        *out << llvm::format("%llx %llx ", static_cast<unsigned long long>(*address), static_cast<unsigned long long>(size))
+             << display << "\n";
+    }
+    out->flush();
+}
@@ -0,0 +1,378 @@
+#include "../../include/ModuleOptimizer.hpp"
+#include "../../include/Logger.hpp"
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <unistd.h>
+#include <llvm/Analysis/CGSCCPassManager.h>
+#include <llvm/Analysis/LoopAnalysisManager.h>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/ADT/SetVector.h>
+#include <llvm/IR/InstIterator.h>
+#include <llvm/IR/PassManager.h>
+#include <llvm/IR/Verifier.h>
+#include <llvm/Linker/Linker.h>
+#include <llvm/MC/TargetRegistry.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Support/MD5.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/ThreadPool.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Target/TargetMachine.h>
+#include <llvm/Target/TargetOptions.h>
+#include <llvm/Transforms/InstCombine/InstCombine.h>
+#include <llvm/Transforms/Scalar/EarlyCSE.h>
+#include <llvm/Transforms/Scalar/InductiveRangeCheckElimination.h>
+#include <llvm/Transforms/Scalar/LICM.h>
+#include <llvm/Transforms/Scalar/LoopPassManager.h>
+#include <llvm/Transforms/Scalar/LoopRotation.h>
+#include <llvm/Transforms/Scalar/SROA.h>
+#include <llvm/Transforms/Scalar/SimplifyCFG.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+#include <llvm/Transforms/Utils/SplitModule.h>
+
+ModuleOptimizer::ModuleOptimizer(unsigned jobs, std::string cacheDir)
+    : jobs(jobs), cacheDir(std::move(cacheDir)) {
+    llvm::InitializeNativeTarget();
+}
+
+/// @brief read the runtime bitcode, without it runtime calls stay external
+/// @param path runtime bitcode file
+/// @return whether the runtime was loaded
+bool ModuleOptimizer::loadRuntime(const std::string &path) {
+    auto buffer = llvm::MemoryBuffer::getFile(path);
+    if (!buffer) {
+        return false;
+    }
+    auto bytes = (*buffer)->getBuffer();
+    runtime.assign(bytes.begin(), bytes.end());
+
+    llvm::MD5 hash;
+    hash.update(bytes);
+    llvm::MD5::MD5Result result;
+    hash.final(result);
+    runtimeDigest = result.digest().str().str();
+    return true;
+}
+
+/// @brief optimize the module, the result is linked into the given context
+/// @param module fully generated module, it is consumed by the split
+/// @param ctx context owning the module
+/// @return optimized module
+std::unique_ptr<llvm::Module> ModuleOptimizer::run(std::unique_ptr<llvm::Module> module, llvm::LLVMContext &ctx) {
+    if (llvm::verifyModule(*module, &llvm::errs())) {
+        llvm::errs() << "[LoxVM]: module is broken, skip optimization\n";
+        return module;
+    }
+    bool cached = !cacheDir.empty();
+    auto parts = cached ? splitPerFunction(*module) : split(*module, partitionCount(*module));
+    size_t generated = parts.size();
+    if (!runtime.empty()) {
+        parts.push_back(runtime);
+    }
+
+    // every partition lives in its own context, so the workers share nothing
+    std::vector<Bitcode> optimized(parts.size());
+    std::atomic<size_t> hits{0};
+    llvm::ThreadPool pool(llvm::hardware_concurrency(jobs));
+    for (size_t i = 0; i < parts.size(); ++i) {
+        pool.async([this, cached, generated, &parts, &optimized, &hits, i] {
+            bool importRuntime = i < generated;
+            if (!cached) {
+                optimized[i] = optimizePartition(parts[i], importRuntime);
+                return;
+            }
+            auto key = cacheKey(parts[i]);
+            if (readCache(key, optimized[i])) {
+                hits++;
+                return;
+            }
+            optimized[i] = optimizePartition(parts[i], importRuntime);
+            writeCache(key, optimized[i]);
+        });
+    }
+    pool.wait();
+
+    if (cached) {
+        llvm::errs() << "[LoxVM]: " << hits << "/" << parts.size() << " functions reused from " << cacheDir << "\n";
+    }
+    return link(optimized, *module, ctx);
+}
+
+/// @brief partitions are sized by the number of function definitions
+unsigned ModuleOptimizer::partitionCount(const llvm::Module &module) const {
+    unsigned definitions = 0;
+    for (const auto &fn: module) {
+        if (!fn.isDeclaration()) {
+            definitions++;
+        }
+    }
+    return std::clamp(definitions / functionsPerPartition, 1u, maxPartitions);
+}
+
+std::vector<ModuleOptimizer::Bitcode> ModuleOptimizer::split(llvm::Module &module, unsigned partitions) {
+    std::vector<Bitcode> parts;
+    // SplitModule assigns globals by name hash, which keeps the split stable
+    llvm::SplitModule(module, partitions, [&parts](std::unique_ptr<llvm::Module> part) {
+        parts.push_back(writeBitcode(*part));
+    });
+    return parts;
+}
+
+/// @brief one partition holding the global variables, then one per function
+std::vector<ModuleOptimizer::Bitcode> ModuleOptimizer::splitPerFunction(llvm::Module &module) {
+    externalizeLocals(module);
+
+    std::vector<Bitcode> parts;
+    llvm::ValueToValueMapTy globalsMap;
+    auto globals = llvm::CloneModule(module, globalsMap, [](const llvm::GlobalValue *value) {
+        return llvm::isa<llvm::GlobalVariable>(value);
+    });
+    parts.push_back(writeBitcode(*globals));
+
+    for (const auto &fn: module) {
+        if (!fn.isDeclaration()) {
+            parts.push_back(writeBitcode(*extractFunction(fn)));
+        }
+    }
+    return parts;
+}
+
+/// @brief copy one function into a fresh module, together with declarations
+/// of exactly the globals it references, so its bitcode (and cache key) does
+/// not change when unrelated functions are edited
+std::unique_ptr<llvm::Module> ModuleOptimizer::extractFunction(const llvm::Function &fn) {
+    const auto &module = *fn.getParent();
+    auto part = std::make_unique<llvm::Module>(module.getModuleIdentifier(), module.getContext());
+    part->setSourceFileName(module.getSourceFileName());
+    part->setTargetTriple(module.getTargetTriple());
+    part->setDataLayout(module.getDataLayout());
+
+    // collect referenced globals in instruction order, looking through constant expressions
+    llvm::SetVector<const llvm::GlobalValue *> referenced;
+    llvm::SmallVector<const llvm::Constant *, 8> worklist;
+    for (const auto &inst: llvm::instructions(fn)) {
+        for (const auto &operand: inst.operands()) {
+            if (auto constant = llvm::dyn_cast<llvm::Constant>(operand.get())) {
+                worklist.push_back(constant);
+            }
+        }
+        while (!worklist.empty()) {
+            auto constant = worklist.pop_back_val();
+            if (auto global = llvm::dyn_cast<llvm::GlobalValue>(constant)) {
+                referenced.insert(global);
+                continue;
+            }
+            for (const auto &operand: constant->operands()) {
+                worklist.push_back(llvm::cast<llvm::Constant>(operand.get()));
+            }
+        }
+    }
+
+    llvm::ValueToValueMapTy map;
+    for (auto global: referenced) {
+        if (global == &fn) {
+            continue;
+        }
+        if (auto callee = llvm::dyn_cast<llvm::Function>(global)) {
+            auto decl = llvm::Function::Create(callee->getFunctionType(), llvm::GlobalValue::ExternalLinkage, callee->getName(), part.get());
+            decl->copyAttributesFrom(callee);
+            map[callee] = decl;
+        } else if (auto variable = llvm::dyn_cast<llvm::GlobalVariable>(global)) {
+            auto decl = new llvm::GlobalVariable(*part, variable->getValueType(), variable->isConstant(), llvm::GlobalValue::ExternalLinkage, nullptr, variable->getName());
+            decl->copyAttributesFrom(variable);
+            map[variable] = decl;
+        }
+    }
+
+    auto clone = llvm::Function::Create(fn.getFunctionType(), fn.getLinkage(), fn.getName(), part.get());
+    clone->copyAttributesFrom(&fn);
+    map[&fn] = clone;
+    auto cloneArg = clone->arg_begin();
+    for (const auto &arg: fn.args()) {
+        cloneArg->setName(arg.getName());
+        map[&arg] = &*cloneArg++;
+    }
+    llvm::SmallVector<llvm::ReturnInst *, 4> returns;
+    llvm::CloneFunctionInto(clone, &fn, map, llvm::CloneFunctionChangeType::DifferentModule, returns);
+    // cloning always inserts llvm.dbg.cu, an empty one only produces reader warnings
+    if (auto units = part->getNamedMetadata("llvm.dbg.cu"); units != nullptr && units->getNumOperands() == 0) {
+        part->eraseNamedMetadata(units);
+    }
+    return part;
+}
+
+/// @brief locals cannot be declared in another partition, so give them
+/// external hidden linkage. Unnamed constants are named after their
+/// contents, otherwise a new string literal would renumber every later one
+/// and invalidate the cache entries of unrelated functions.
+void ModuleOptimizer::externalizeLocals(llvm::Module &module) {
+    for (auto &global: module.globals()) {
+        if (!global.hasLocalLinkage()) {
+            continue;
+        }
+        if (!global.hasName() && global.hasInitializer()) {
+            llvm::MD5 hash;
+            if (auto data = llvm::dyn_cast<llvm::ConstantDataSequential>(global.getInitializer())) {
+                hash.update(data->getRawDataValues());
+            }
+            llvm::MD5::MD5Result result;
+            hash.final(result);
+            global.setName("lox.const." + result.digest().str().substr(0, 16));
+        }
+        global.setLinkage(llvm::GlobalValue::ExternalLinkage);
+        global.setVisibility(llvm::GlobalValue::HiddenVisibility);
+    }
+    for (auto &fn: module) {
+        if (fn.hasLocalLinkage()) {
+            fn.setLinkage(llvm::GlobalValue::ExternalLinkage);
+            fn.setVisibility(llvm::GlobalValue::HiddenVisibility);
+        }
+    }
+}
+
+std::string ModuleOptimizer::cacheKey(const Bitcode &input) const {
+    llvm::MD5 hash;
+    hash.update(cacheVersion);
+    hash.update(targetCpu);
+    hash.update("O2");
+    hash.update(runtimeDigest);
+    hash.update(llvm::StringRef(input.data(), input.size()));
+    llvm::MD5::MD5Result result;
+    hash.final(result);
+    return result.digest().str().str();
+}
+
+bool ModuleOptimizer::readCache(const std::string &key, Bitcode &output) const {
+    std::ifstream file{std::filesystem::path(cacheDir) / (key + ".bc"), std::ios::binary | std::ios::ate};
+    if (!file) {
+        return false;
+    }
+    output.resize(file.tellg());
+    file.seekg(0, std::ios::beg);
+    return static_cast<bool>(file.read(output.data(), output.size()));
+}
+
+/// @brief write to a temporary file first, a concurrent build never sees a torn entry
+void ModuleOptimizer::writeCache(const std::string &key, const Bitcode &output) const {
+    std::error_code error;
+    std::filesystem::create_directories(cacheDir, error);
+    auto path = std::filesystem::path(cacheDir) / (key + ".bc");
+    auto temp = path;
+    temp += ".tmp" + std::to_string(getpid()) + "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    {
+        std::ofstream file{temp, std::ios::binary};
+        if (!file.write(output.data(), output.size())) {
+            return;
+        }
+    }
+    std::filesystem::rename(temp, path, error);
+}
+
+std::unique_ptr<llvm::Module> ModuleOptimizer::link(std::vector<Bitcode> &parts, const llvm::Module &original, llvm::LLVMContext &ctx) {
+    auto linked = std::make_unique<llvm::Module>(original.getModuleIdentifier(), ctx);
+    linked->setSourceFileName(original.getSourceFileName());
+    linked->setTargetTriple(original.getTargetTriple());
+
+    for (auto &part: parts) {
+        llvm::MemoryBufferRef buffer(llvm::StringRef(part.data(), part.size()), "partition");
+        auto parsed = llvm::parseBitcodeFile(buffer, ctx);
+        if (!parsed) {
+            Error::ErrorLogMessage() << "[LoxVM]: cannot read partition: " << llvm::toString(parsed.takeError());
+        }
+        if (llvm::Linker::linkModules(*linked, std::move(*parsed))) {
+            Error::ErrorLogMessage() << "[LoxVM]: cannot link partition";
+        }
+    }
+    return linked;
+}
+
+/// @brief runs on a worker thread, nothing here may touch the caller's context
+ModuleOptimizer::Bitcode ModuleOptimizer::optimizePartition(const Bitcode &input, bool importRuntime) const {
+    llvm::LLVMContext ctx;
+    llvm::MemoryBufferRef buffer(llvm::StringRef(input.data(), input.size()), "partition");
+    auto module = llvm::parseBitcodeFile(buffer, ctx);
+    if (!module) {
+        Error::ErrorLogMessage() << "[LoxVM]: cannot read partition: " << llvm::toString(module.takeError());
+    }
+    if (importRuntime) {
+        linkRuntime(**module);
+    }
+    optimize(**module);
+    return writeBitcode(**module);
+}
+
+/// @brief import the runtime functions the partition calls; available_externally
+/// bodies may be inlined but are never emitted, the optimizer drops the rest
+void ModuleOptimizer::linkRuntime(llvm::Module &module) const {
+    if (runtime.empty()) {
+        return;
+    }
+    llvm::MemoryBufferRef buffer(llvm::StringRef(runtime.data(), runtime.size()), "runtime");
+    auto parsed = llvm::parseBitcodeFile(buffer, module.getContext());
+    if (!parsed) {
+        Error::ErrorLogMessage() << "[LoxVM]: cannot read runtime: " << llvm::toString(parsed.takeError());
+    }
+    for (auto &fn: **parsed) {
+        if (!fn.isDeclaration() && !fn.hasLocalLinkage()) {
+            fn.setLinkage(llvm::GlobalValue::AvailableExternallyLinkage);
+        }
+    }
+    if (llvm::Linker::linkModules(module, std::move(*parsed), llvm::Linker::Flags::LinkOnlyNeeded)) {
+        Error::ErrorLogMessage() << "[LoxVM]: cannot link runtime";
+    }
+}
+
+void ModuleOptimizer::optimize(llvm::Module &module) {
+    std::string error;
+    auto target = llvm::TargetRegistry::lookupTarget(module.getTargetTriple(), error);
+    if (target == nullptr) {
+        Error::ErrorLogMessage() << "[LoxVM]: " << error;
+    }
+    std::unique_ptr<llvm::TargetMachine> machine(target->createTargetMachine(
+        module.getTargetTriple(), targetCpu, "", llvm::TargetOptions(), llvm::Reloc::PIC_
+    ));
+    module.setDataLayout(machine->createDataLayout());
+
+    llvm::LoopAnalysisManager lam;
+    llvm::FunctionAnalysisManager fam;
+    llvm::CGSCCAnalysisManager cgam;
+    llvm::ModuleAnalysisManager mam;
+    llvm::PassBuilder passBuilder(machine.get());
+    passBuilder.registerModuleAnalyses(mam);
+    passBuilder.registerCGSCCAnalyses(cgam);
+    passBuilder.registerFunctionAnalyses(fam);
+    passBuilder.registerLoopAnalyses(lam);
+    passBuilder.crossRegisterProxies(lam, fam, cgam, mam);
+    // split loops over lists so the main range runs without bounds checks.
+    // IRCE must see the checks before IndVars rewrites them into exit tests,
+    // so it runs up front, after just enough cleanup to rotate the loops and
+    // hoist the list lengths out of them
+    passBuilder.registerPipelineStartEPCallback([](llvm::ModulePassManager &mpm, llvm::OptimizationLevel) {
+        llvm::LoopPassManager lpm;
+        lpm.addPass(llvm::LoopRotatePass());
+        lpm.addPass(llvm::LICMPass());
+        llvm::FunctionPassManager fpm;
+        fpm.addPass(llvm::SROAPass());
+        fpm.addPass(llvm::EarlyCSEPass(true));
+        fpm.addPass(llvm::SimplifyCFGPass());
+        fpm.addPass(llvm::InstCombinePass());
+        fpm.addPass(llvm::createFunctionToLoopPassAdaptor(std::move(lpm), /*UseMemorySSA=*/true));
+        fpm.addPass(llvm::IRCEPass());
+        mpm.addPass(llvm::createModuleToFunctionPassAdaptor(std::move(fpm)));
+    });
+
+    auto pipeline = passBuilder.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::O2);
+    pipeline.run(module, mam);
+}
+
+ModuleOptimizer::Bitcode ModuleOptimizer::writeBitcode(const llvm::Module &module) {
+    Bitcode output;
+    llvm::raw_svector_ostream os(output);
+    llvm::WriteBitcodeToFile(module, os);
+    return output;
+}
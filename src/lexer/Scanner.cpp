@@ -1,8 +1,10 @@
 #include <iostream>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "../../include/Logger.hpp"
+#include "../../include/LoxString.hpp"
 #include "../../include/Scanner.hpp"
 #include "../../include/Token.hpp"
 #include "../../include/lox.hpp"
@@ -28,9 +30,11 @@ const unordered_map<string, TokenType> Scanner::keywords = {
     {"true", TRUE},
     {"var", VAR},
     {"while", WHILE},
+    {"yield", YIELD},
 };
 
-Scanner::Scanner(string source) : source(std::move(source)) {}
+Scanner::Scanner(string source, Error::ErrorContext &errors)
+    : source(std::move(source)), errors(errors) {}
 
 vector<Token> Scanner::scanTokens() {
     while (!isAtEnd()) {
@@ -72,8 +76,12 @@ void Scanner::addToken(TokenType type) { addToken(type, Object::make_obj("")); }
 
 void Scanner::addToken(TokenType type, Object literal) {
     string text = source.substr(start, current - start);
-    Token token(type, text, literal, line);
-    tokens.push_back(token);
+    Token token(type, text, std::move(literal), line);
+    // intern names once here instead of on every lookup
+    if (type == IDENTIFIER || type == THIS || type == SUPER) {
+        token.name();
+    }
+    tokens.push_back(std::move(token));
 }
 
 bool Scanner::match(char expected) {
@@ -192,7 +200,7 @@ void Scanner::scanToken() {
             } else if (isAlpha(c)) {
                 identifier();
             } else {
-                Error::addError(line, "", "Unexpected character '" + std::to_string(c) + "'.");
+                errors.addError(line, "", "Unexpected character '" + std::to_string(c) + "'.");
                 // lox::error(line, "Unexpected character.");
             }
             break;
@@ -208,7 +216,7 @@ void Scanner::String() {
 
     // Unterminated string.
     if (isAtEnd()) {
-        Error::addError(line, "", "Unterminated string.");
+        errors.addError(line, "", "Unterminated string.");
         // lox::error(line, "Unterminated string.");
         return;
     }
@@ -218,7 +226,7 @@ void Scanner::String() {
 
     // Trim the surrounding quotes.
     string value = source.substr(start + 1, current - start - 2);
-    addToken(STRING, Object::make_obj(value));
+    addToken(STRING, Object::make_obj(LoxString::intern(value)));
 }
 
 void Scanner::Number() {
@@ -4,6 +4,7 @@
 #include "../../include/LoxCallable.hpp"
 #include "../../include/LoxClass.hpp"
 #include "../../include/LoxInstance.hpp"
+#include "../../include/LoxString.hpp"
 #include "../../include/Token.hpp"
 
 using std::string;
@@ -18,3 +19,10 @@ Token::Token(TokenType type, string lexeme, Object literal, int line)
 string Token::toString() {
   return to_string(type) + " " + lexeme + " " + literal.toString();
 }
+
+const LoxString *Token::name() const {
+    if (interned == nullptr) {
+        interned = LoxString::intern(lexeme).get();
+    }
+    return interned;
+}
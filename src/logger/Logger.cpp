@@ -2,23 +2,19 @@
 
 namespace Error
 {
-    std::vector<ErrorInfo> exceptionList{};
-    bool hadError = false;
-    bool hadRuntimeError = false;
-
-    void addRuntimeError(const RuntimeError &error) noexcept
+    void ErrorContext::addRuntimeError(const RuntimeError &error) noexcept
     {
         exceptionList.emplace_back(error.token.line, "", error.what());
         hadRuntimeError = true;
     }
 
-    void addError(unsigned int line, std::string where, std::string message) noexcept
+    void ErrorContext::addError(unsigned int line, std::string where, std::string message) noexcept
     {
         exceptionList.emplace_back(line, std::move(where), std::move(message));
         hadError = true;
     }
 
-    void addError(const Token &token, std::string message) noexcept
+    void ErrorContext::addError(const Token &token, std::string message) noexcept
     {
         if (token.type == TokenType::TOKEN_EOF)
         {
@@ -32,13 +28,20 @@ namespace Error
         hadError = true;
     }
 
-    void report() noexcept
+    void ErrorContext::report(std::ostream &out) const noexcept
     {
         for (const auto &exception : exceptionList)
         {
-            std::cerr << "[Line " + std::to_string(exception.line) + "] Error " + exception.where +
-                             ": " + exception.message
-                      << '\n';
+            out << "[Line " + std::to_string(exception.line) + "] Error " + exception.where +
+                       ": " + exception.message
+                << '\n';
         }
     }
-}
\ No newline at end of file
+
+    void ErrorContext::clear() noexcept
+    {
+        exceptionList.clear();
+        hadError = false;
+        hadRuntimeError = false;
+    }
+}
\ No newline at end of file
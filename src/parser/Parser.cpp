@@ -112,8 +112,14 @@ shared_ptr<Function> Parser::function(string kind) {
         returnType = consume(IDENTIFIER, "Expect function return value type.");
     }
     consume(LEFT_BRACE, "Syntax Error. Expect '{' before " + kind + " body.");
+    // yields of nested functions belong to them
+    bool enclosingSawYield = sawYield;
+    sawYield = false;
     auto body = block();
     auto func = std::make_shared<Function>(identifier, parameters, body, returnType);
+    func->nodeId = ++nextNodeId;
+    func->isGenerator = sawYield;
+    sawYield = enclosingSawYield;
     return func;
 }
 
@@ -209,7 +215,9 @@ shared_ptr<Stmt> Parser::forStatement() {
     if (condition == nullptr) {
         condition = std::make_shared<Literal<Object>>(Object::make_obj(true));
     }
-    body = std::make_shared<While>(condition, body);
+    auto loop = std::make_shared<While>(condition, body);
+    loop->nodeId = ++nextNodeId;
+    body = loop;
 
     if (initializer != nullptr) {
         vector<shared_ptr<Stmt>> stmts2;
@@ -239,7 +247,9 @@ shared_ptr<Stmt> Parser::ifStatement() {
     }
     auto else_branch = match({ELSE}) ? statement() : nullptr;
 
-    return std::make_shared<If>(main_brach, elif_branches, else_branch);
+    auto stmt = std::make_shared<If>(main_brach, elif_branches, else_branch);
+    stmt->nodeId = ++nextNodeId;
+    return stmt;
     // return shared_ptr<Stmt>(new If(main_brach, elif_branches, else_branch));
 }
 
@@ -277,7 +287,9 @@ shared_ptr<Stmt> Parser::whileStatement() {
     shared_ptr<Expr<Object>> condition = expression();
     consume(RIGHT_PAREN, "Syntax Error. Expect ')' after condition.");
     shared_ptr<Stmt> body = statement();
-    return std::make_shared<While>(condition, body);
+    auto loop = std::make_shared<While>(condition, body);
+    loop->nodeId = ++nextNodeId;
+    return loop;
 }
 
 /// @brief parse a control statement, like {breal; continue}
@@ -317,6 +329,9 @@ shared_ptr<Expr<Object>> Parser::expression() { return assignment(); }
 /// @brief parse the assignment, like a=1
 /// @return
 shared_ptr<Expr<Object>> Parser::assignment() {
+    if (match({YIELD})) {
+        return yieldExpression();
+    }
     shared_ptr<Expr<Object>> expr = orExpression();
     if (match({EQUAL})) {
         Token equals = previous();
@@ -324,6 +339,9 @@ shared_ptr<Expr<Object>> Parser::assignment() {
 
         if (auto subscript = dynamic_cast<Subscript<Object> *>(expr.get());
             subscript != nullptr) {
+            if (subscript->slice) {
+                throw error(equals, "Syntax Error. Can not assign to a slice.");
+            }
             Token name = subscript->identifier;
             return std::make_shared<Subscript<Object>>(
                 std::move(name), subscript->index, std::move(value)
@@ -342,6 +360,18 @@ shared_ptr<Expr<Object>> Parser::assignment() {
     return expr;
 }
 
+/// @brief parse a yield expression, like yield value or a bare yield
+/// @return
+shared_ptr<Expr<Object>> Parser::yieldExpression() {
+    Token keyword = previous();
+    sawYield = true;
+    shared_ptr<Expr<Object>> value;
+    if (!check(SEMICOLON) && !check(RIGHT_PAREN) && !check(RIGHT_BRACKET) && !check(COMMA)) {
+        value = assignment();
+    }
+    return std::make_shared<Yield<Object>>(keyword, value);
+}
+
 /// @brief parse the or expression, like 1 or 2
 /// @return
 shared_ptr<Expr<Object>> Parser::orExpression() {
@@ -515,7 +545,9 @@ shared_ptr<Expr<Object>> Parser::finishCall(shared_ptr<Expr<Object>> callee) {
     Token paren =
         consume(RIGHT_PAREN, "Syntax Error. Expect ')' after arguments.");
 
-    return std::make_shared<Call<Object>>(callee, paren, arguments);
+    auto call = std::make_shared<Call<Object>>(callee, paren, arguments);
+    call->nodeId = ++nextNodeId;
+    return call;
 }
 
 /// @brief parse a subscript expression, like a[]
@@ -534,12 +566,18 @@ shared_ptr<Expr<Object>> Parser::subscript() {
     return expr;
 }
 
-/// @brief finih parsing, that is implement
+/// @brief finih parsing, that is implement, a[i] or a slice a[i:j], a[:j], a[i:]
 /// @param expr
 /// @return
 shared_ptr<Expr<Object>>
 Parser::finishSubscript(shared_ptr<Expr<Object>> identifier) {
-    auto index = orExpression();
+    shared_ptr<Expr<Object>> index = check(COLON) ? nullptr : orExpression();
+    bool slice = false;
+    shared_ptr<Expr<Object>> end = nullptr;
+    if (match({COLON})) {
+        slice = true;
+        end = check(TokenType::RIGHT_BRACKET) ? nullptr : orExpression();
+    }
     consume(TokenType::RIGHT_BRACKET, "Syntax Error. Expect ']' after arguments.");
 
     // Forbid calling rvalues.
@@ -549,7 +587,7 @@ Parser::finishSubscript(shared_ptr<Expr<Object>> identifier) {
 
     auto var = dynamic_cast<Variable<Object> *>(identifier.get())->name;
 
-    return std::make_shared<Subscript<Object>>(var, index, nullptr);
+    return std::make_shared<Subscript<Object>>(var, index, nullptr, slice, end);
 }
 
 /// @brief parse the lambda function
@@ -598,9 +636,7 @@ shared_ptr<Expr<Object>> Parser::primary() {
         );
     }
     if (match({STRING})) {
-        return std::make_shared<Literal<Object>>(
-            Object::make_obj(std::get<std::string>(previous().literal.data))
-        );
+        return std::make_shared<Literal<Object>>(previous().literal);
     }
 
     if (match({SUPER})) {
@@ -714,7 +750,7 @@ Token Parser::consume(TokenType type, string message) {
 
 // error handle function and recovery
 runtime_error Parser::error(Token token, string message) {
-    Error::addError(token, std::move(message));
+    errors.addError(token, std::move(message));
     if (token.type == TOKEN_EOF) {
         return runtime_error(to_string(token.line) + " at end" + message);
     } else {
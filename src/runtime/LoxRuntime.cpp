@@ -0,0 +1,95 @@
+#include "../../include/LoxRuntime.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+void *lox_alloc(int64_t size) {
+    void *memory = std::malloc(static_cast<size_t>(size));
+    if (memory == nullptr) {
+        lox_panic("out of memory");
+    }
+    return memory;
+}
+
+void lox_panic(const char *message) {
+    std::fflush(stdout);
+    std::fprintf(stderr, "Runtime Error. %s\n", message);
+    std::exit(70);
+}
+
+// string
+char *lox_str_concat(const char *left, const char *right) {
+    size_t leftLen = std::strlen(left);
+    size_t rightLen = std::strlen(right);
+    auto result = static_cast<char *>(lox_alloc(static_cast<int64_t>(leftLen + rightLen + 1)));
+    std::memcpy(result, left, leftLen);
+    std::memcpy(result + leftLen, right, rightLen + 1);
+    return result;
+}
+
+int32_t lox_str_len(const char *str) {
+    return static_cast<int32_t>(std::strlen(str));
+}
+
+// list
+LoxRtList *lox_list_new(int64_t elemSize, int64_t capacity) {
+    auto list = static_cast<LoxRtList *>(lox_alloc(sizeof(LoxRtList)));
+    list->length = 0;
+    list->capacity = capacity > 0 ? capacity : 4;
+    list->data = static_cast<char *>(lox_alloc(list->capacity * elemSize));
+    return list;
+}
+
+int64_t lox_list_len(const LoxRtList *list) {
+    return list->length;
+}
+
+static inline void lox_list_reserve(LoxRtList *list, int64_t elemSize) {
+    if (list->length < list->capacity) {
+        return;
+    }
+    list->capacity *= 2;
+    list->data = static_cast<char *>(std::realloc(list->data, static_cast<size_t>(list->capacity * elemSize)));
+    if (list->data == nullptr) {
+        lox_panic("out of memory");
+    }
+}
+
+void lox_list_append_i32(LoxRtList *list, int32_t value) {
+    lox_list_reserve(list, sizeof(int32_t));
+    reinterpret_cast<int32_t *>(list->data)[list->length++] = value;
+}
+
+void lox_list_append_f64(LoxRtList *list, double value) {
+    lox_list_reserve(list, sizeof(double));
+    reinterpret_cast<double *>(list->data)[list->length++] = value;
+}
+
+// print, a value is followed by a space like the interpreter's print
+void lox_print_i32(int32_t value) {
+    std::printf("%d ", value);
+}
+
+void lox_print_f64(double value) {
+    // shortest precision that reads back to the same double
+    char buffer[32];
+    for (int precision = 1; precision <= 17; ++precision) {
+        std::snprintf(buffer, sizeof(buffer), "%.*g", precision, value);
+        if (std::strtod(buffer, nullptr) == value) {
+            break;
+        }
+    }
+    std::printf("%s ", buffer);
+}
+
+void lox_print_bool(int32_t value) {
+    std::fputs(value ? "true " : "false ", stdout);
+}
+
+void lox_print_str(const char *value) {
+    std::printf("%s ", value);
+}
+
+void lox_print_newline() {
+    std::putchar('\n');
+}
@@ -3,8 +3,10 @@
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <utility>
 
 #include "../../include/Environment.hpp"
+#include "../../include/LoxString.hpp"
 #include "../../include/RuntimeError.hpp"
 
 using std::map;
@@ -12,8 +14,16 @@ using std::string;
 
 Environment::Environment(shared_ptr<Environment> enclosing_) : enclosing(enclosing_) {}
 
-void Environment::define(string name, Object value) {
-    values[name] = value;
+void Environment::define(const LoxString *name, Object value) {
+    values[name] = std::move(value);
+}
+
+void Environment::define(const Token &name, Object value) {
+    values[name.name()] = std::move(value);
+}
+
+void Environment::define(const string &name, Object value) {
+    values[LoxString::intern(name).get()] = std::move(value);
 }
 
 // llvm environment
@@ -22,9 +32,10 @@ llvm::Value *Environment::define(string name, llvm::Value *value) {
     return value;
 }
 
-Object Environment::get(Token name) {
-    if (values.find(name.lexeme) != values.end()) {
-        return values.at(name.lexeme);
+Object Environment::get(const Token &name) {
+    auto found = values.find(name.name());
+    if (found != values.end()) {
+        return found->second;
     }
     if (enclosing) {
         return enclosing->get(name);
@@ -32,29 +43,30 @@ Object Environment::get(Token name) {
     throw RuntimeError(name, "Undefined variable '" + name.lexeme + "'.");
 }
 
-Object Environment::getAt(int distance, string name) {
-    return ancestor(distance)->values[name];
+Object Environment::getAt(int distance, const LoxString *name) {
+    return ancestorOf(distance)->values[name];
 }
 
 llvm::Value *Environment::lookup(const string &name) {
     return resolve(name)->llvmRecord_[name];
 }
 
-void Environment::assign(Token name, Object value) {
-    if (values.find(name.lexeme) != values.end()) {
-        values[name.lexeme] = value;
+void Environment::assign(const Token &name, Object value) {
+    auto found = values.find(name.name());
+    if (found != values.end()) {
+        found->second = std::move(value);
         return;
     }
     if (enclosing != nullptr) {
-        enclosing->assign(name, value);
+        enclosing->assign(name, std::move(value));
         return;
     }
 
     throw RuntimeError(name, "Undefined variable '" + name.lexeme + "'.");
 }
 
-void Environment::assignAt(int distance, Token name, Object value) {
-    ancestor(distance)->values[name.lexeme] = value;
+void Environment::assignAt(int distance, const Token &name, Object value) {
+    ancestorOf(distance)->values[name.name()] = std::move(value);
 }
 
 shared_ptr<Environment> Environment::ancestor(int distance) {
@@ -63,4 +75,12 @@ shared_ptr<Environment> Environment::ancestor(int distance) {
         environment = environment->enclosing;
     }
     return environment;
+}
+
+Environment *Environment::ancestorOf(int distance) {
+    Environment *environment = this;
+    for (int i = 0; i < distance; i++) {
+        environment = environment->enclosing.get();
+    }
+    return environment;
 }
\ No newline at end of file
@@ -0,0 +1,24 @@
+#include "../../include/LoxString.hpp"
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+LoxString::LoxString(std::string chars_, bool interned_)
+    : chars(std::move(chars_)), hashValue(std::hash<std::string>{}(chars)), interned(interned_) {}
+
+shared_ptr<LoxString> LoxString::intern(std::string_view chars) {
+    // keys view the characters of the interned string itself; the table is
+    // never destroyed, interned strings may be used until the process exits
+    static auto *table = new std::unordered_map<std::string_view, shared_ptr<LoxString>>();
+    static std::mutex lock;
+
+    std::lock_guard<std::mutex> guard(lock);
+    auto found = table->find(chars);
+    if (found != table->end()) {
+        return found->second;
+    }
+    auto string = std::make_shared<LoxString>(std::string(chars), true);
+    table->emplace(string->str(), string);
+    return string;
+}
@@ -0,0 +1,29 @@
+#include "../../include/NumberFormat.hpp"
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+size_t formatNumber(double value, char *buffer) {
+    // to_chars would write "-nan", Lox has a single nan
+    if (std::isnan(value)) {
+        std::memcpy(buffer, "nan", 3);
+        return 3;
+    }
+    // plain notation in the range JavaScript prints without an exponent, so
+    // 2000000 does not come out as 2e+06
+    double magnitude = std::fabs(value);
+    if (magnitude == 0 || (magnitude >= 1e-6 && magnitude < 1e21)) {
+        auto result = std::to_chars(buffer, buffer + maxNumberLength, value, std::chars_format::fixed);
+        if (result.ec == std::errc()) {
+            return static_cast<size_t>(result.ptr - buffer);
+        }
+    }
+    // the shortest round-trip form is at most 24 characters, e.g. -2.2250738585072014e-308
+    auto result = std::to_chars(buffer, buffer + maxNumberLength, value);
+    return static_cast<size_t>(result.ptr - buffer);
+}
+
+size_t formatNumber(int value, char *buffer) {
+    auto result = std::to_chars(buffer, buffer + maxNumberLength, value);
+    return static_cast<size_t>(result.ptr - buffer);
+}
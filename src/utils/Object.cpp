@@ -1,14 +1,16 @@
 #include "../../include/Object.hpp"
+#include "../../include/LoxString.hpp"
+#include "../../include/NumberFormat.hpp"
 #include <memory>
 #include <string>
+#include <utility>
 using std::shared_ptr;
 using std::string;
-using std::to_string;
 
 string Object::toString() {
     switch (data.index()) {
         case 0:
-            return std::get<string>(data);
+            return std::get<shared_ptr<LoxString>>(data)->str();
         case 2:
             return std::get<bool>(data) ? "true" : "false";
         case 3:
@@ -23,13 +25,29 @@ string Object::toString() {
         case 7:
             return "<obj class>";
             // return lox_class->toString();
-        case 8:
-            return to_string(std::get<int>(data));
-        default:
-            return to_string(std::get<double>(data));
+        case 8: {
+            char buffer[maxNumberLength];
+            return string(buffer, formatNumber(std::get<int>(data), buffer));
+        }
+        default: {
+            char buffer[maxNumberLength];
+            return string(buffer, formatNumber(std::get<double>(data), buffer));
+        }
     }
 }
 
+Object Object::make_obj(std::string data_) {
+    Object obj;
+    obj.data = std::make_shared<LoxString>(std::move(data_));
+    return obj;
+}
+
+Object Object::make_obj(const char *data_) {
+    Object obj;
+    obj.data = LoxString::intern(data_);
+    return obj;
+}
+
 Object Object::make_nil_obj() {
     Object nil_obj;
     nil_obj.data = std::monostate{};
@@ -0,0 +1,144 @@
+#include "../../include/Profile.hpp"
+#include <fstream>
+#include <functional>
+#include <sstream>
+
+Profile::Profile(const std::string &source) {
+    std::stringstream hash;
+    hash << std::hex << std::hash<std::string>{}(source);
+    sourceHash = hash.str();
+}
+
+void Profile::branch(int node, bool taken) {
+    auto &entry = branches[node];
+    if (taken) {
+        entry.taken++;
+    } else {
+        entry.notTaken++;
+    }
+}
+
+void Profile::call(int node, int callee) {
+    auto &entry = calls[node];
+    if (entry.count == 0) {
+        entry.callee = callee;
+    } else if (entry.callee != callee) {
+        entry.callee = -1;
+    }
+    entry.count++;
+}
+
+void Profile::enter(int node, const Arguments &arguments) {
+    auto &entry = functions[node];
+    entry.count++;
+    entry.paramTypes.resize(arguments.size());
+    for (size_t i = 0; i < arguments.size(); i++) {
+        merge(entry.paramTypes[i], typeName(arguments[i]));
+    }
+}
+
+void Profile::leave(int node, const Object &result) {
+    merge(functions[node].returnType, typeName(result));
+}
+
+void Profile::merge(std::string &seen, const std::string &type) {
+    if (seen.empty()) {
+        seen = type;
+    } else if (seen != type) {
+        seen = "mixed";
+    }
+}
+
+/// @brief the type() name of a value
+std::string Profile::typeName(const Object &object) {
+    switch (object.data.index()) {
+        case 0:
+            return "str";
+        case 1:
+            return "float";
+        case 2:
+            return "bool";
+        case 3:
+            return "nil";
+        case 4:
+            return "list";
+        case 5:
+            return "fn";
+        case 6:
+            return "instance";
+        case 7:
+            return "class";
+        case 8:
+            return "int";
+    }
+    return "mixed";
+}
+
+bool Profile::save(const std::string &path) const {
+    std::ofstream out(path);
+    if (!out) {
+        return false;
+    }
+    out << "loxprof " << version << " " << sourceHash << "\n";
+    for (auto &[node, entry]: branches) {
+        out << "branch " << node << " " << entry.taken << " " << entry.notTaken << "\n";
+    }
+    for (auto &[node, entry]: calls) {
+        out << "call " << node << " " << entry.count << " " << entry.callee << "\n";
+    }
+    for (auto &[node, entry]: functions) {
+        out << "function " << node << " " << entry.count << " "
+            << (entry.returnType.empty() ? "nil" : entry.returnType);
+        for (auto &type: entry.paramTypes) {
+            out << " " << type;
+        }
+        out << "\n";
+    }
+    return static_cast<bool>(out);
+}
+
+/// @brief read a profile, fails if it was recorded from another source
+bool Profile::load(const std::string &path) {
+    std::ifstream in(path);
+    std::string magic, hash;
+    int fileVersion = 0;
+    if (!(in >> magic >> fileVersion >> hash) || magic != "loxprof" || fileVersion != version || hash != sourceHash) {
+        return false;
+    }
+    std::string line;
+    std::getline(in, line);
+    while (std::getline(in, line)) {
+        std::istringstream record(line);
+        std::string kind;
+        int node = 0;
+        record >> kind >> node;
+        if (kind == "branch") {
+            record >> branches[node].taken >> branches[node].notTaken;
+        } else if (kind == "call") {
+            record >> calls[node].count >> calls[node].callee;
+        } else if (kind == "function") {
+            auto &entry = functions[node];
+            record >> entry.count >> entry.returnType;
+            std::string type;
+            while (record >> type) {
+                entry.paramTypes.push_back(type);
+            }
+        }
+    }
+    return true;
+}
+
+const Profile::Branch *Profile::findBranch(int node) const {
+    auto found = branches.find(node);
+    return found != branches.end() ? &found->second : nullptr;
+}
+
+const Profile::CallSite *Profile::findCall(int node) const {
+    auto found = calls.find(node);
+    return found != calls.end() ? &found->second : nullptr;
+}
+
+const Profile::FunctionEntry *Profile::findFunction(int node) const {
+    auto found = functions.find(node);
+    return found != functions.end() ? &found->second : nullptr;
+}
@@ -0,0 +1,80 @@
+#ifndef TESTS_RUN_SCRIPT_HPP_
+#define TESTS_RUN_SCRIPT_HPP_
+
+#include "../include/Interpreter.hpp"
+#include "../include/OutputBuffer.hpp"
+#include "../include/Parser.hpp"
+#include "../include/Resolver.hpp"
+#include "../include/RunContext.hpp"
+#include "../include/Scanner.hpp"
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// What a script printed and reported, run through the pipeline of lox::run
+// on a fresh RunContext.
+struct ScriptOutcome {
+    std::string output;
+    std::string diagnostics;
+    bool hadError = false;
+    bool hadRuntimeError = false;
+};
+
+inline ScriptOutcome runScript(const std::string &source) {
+    ScriptOutcome outcome;
+    std::ostringstream diagnostics;
+    {
+        OutputBuffer output(outcome.output);
+        RunContext context(output, diagnostics);
+        Scanner scanner(source, context.errors);
+        std::vector<Token> tokens = scanner.scanTokens();
+        Parser parser(tokens, context.errors);
+        auto statements = parser.parse();
+        if (!context.errors.hadError) {
+            auto interpreter = std::make_shared<Interpreter>(context);
+            auto resolver = std::make_shared<Resolver>(interpreter);
+            resolver->resolve(statements);
+            if (!context.errors.hadError) {
+                interpreter->interpret(statements);
+            }
+        }
+        context.errors.report(diagnostics);
+        outcome.hadError = context.errors.hadError;
+        outcome.hadRuntimeError = context.errors.hadRuntimeError;
+    }
+    outcome.diagnostics = diagnostics.str();
+    return outcome;
+}
+
+// One script and what it must print; a non-empty error is a substring its
+// runtime error must contain.
+struct ScriptCase {
+    const char *name;
+    std::string source;
+    std::string output;
+    std::string error;
+};
+
+/// @brief run every case, report the ones that differ, the exit status
+inline int runCases(const std::vector<ScriptCase> &cases) {
+    int failed = 0;
+    for (const auto &test: cases) {
+        ScriptOutcome outcome = runScript(test.source);
+        bool errorMatches = test.error.empty()
+                                    ? !outcome.hadError && !outcome.hadRuntimeError
+                                    : outcome.hadRuntimeError && outcome.diagnostics.find(test.error) != std::string::npos;
+        if (outcome.output != test.output || !errorMatches) {
+            std::cerr << "FAIL " << test.name << ": output '" << outcome.output << "', expected '" << test.output
+                      << "'; diagnostics '" << outcome.diagnostics << "'\n";
+            failed++;
+        }
+    }
+    if (failed == 0) {
+        std::cout << cases.size() << " cases passed\n";
+    }
+    return failed == 0 ? 0 : 1;
+}
+
+#endif// TESTS_RUN_SCRIPT_HPP_
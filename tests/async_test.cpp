@@ -0,0 +1,17 @@
+// Asynchronous natives: callbacks, where a failed operation is reported, and
+// sleep with durations that are not plain numbers of milliseconds.
+#include "RunScript.hpp"
+#include <vector>
+
+int main() {
+    const std::vector<ScriptCase> cases = {
+            {"callback", "fun got() { print(\"slept\"); } sleep(1, got); print(\"first\");", "first \nslept \n", ""},
+            {"callback error at its call",
+             "fun got(text) { print(text); }\nprint(\"start\");\n\nreadFile(\"/nonexistent/x\", got);",
+             "start \n", "[Line 4] Error : Runtime Error. Could not open file '/nonexistent/x'"},
+            {"waited error at its call", "print(\"start\");\nreadFile(\"/nonexistent/x\");", "start \n",
+             "[Line 2] Error : Runtime Error. Could not open file '/nonexistent/x'"},
+            {"odd durations", "sleep(0.0 / 0.0); sleep(-5); sleep(-1.0 / 0.0); print(\"done\");", "done \n", ""},
+    };
+    return runCases(cases);
+}
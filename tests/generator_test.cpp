@@ -0,0 +1,26 @@
+// Generator bodies run on stacks of their own: deep recursion inside a body
+// must work, and recursion past the end of the stack must be a runtime error.
+#include "RunScript.hpp"
+#include <vector>
+
+namespace {
+    const char *depth = "fun depth(n) { if (n == 0) { return 0; } return depth(n - 1) + 1; }";
+}
+
+int main() {
+    const std::vector<ScriptCase> cases = {
+            {"deep recursion",
+             std::string(depth) + "fun deep(n) { yield depth(n); yield depth(n / 2); }"
+                                  "var g = deep(1500); print(g.next(), g.next(), g.next(), g.done());",
+             "1500 750 nil true \n", ""},
+            {"deep recursion in nested generators",
+             std::string(depth) + "fun inner(n) { yield depth(n); }"
+                                  "fun outer(n) { var g = inner(n); yield g.next() + depth(n); }"
+                                  "print(outer(500).next());",
+             "1000 \n", ""},
+            {"stack overflow",
+             "fun forever(n) { return forever(n + 1); } fun overflow() { yield forever(0); } overflow().next();",
+             "", "Stack overflow in a generator"},
+    };
+    return runCases(cases);
+}
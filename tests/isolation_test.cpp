@@ -0,0 +1,73 @@
+// Runs scripts on several threads at once, each with its own RunContext, and
+// checks that no run sees another's output or errors.
+#include "RunScript.hpp"
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    constexpr int rounds = 200;
+
+    struct Case {
+        const char *name;
+        std::string source;
+        std::string output;     // what every run must print
+        std::string diagnostics;// a substring of what it must report, "" for nothing
+        bool hadError;
+        bool hadRuntimeError;
+    };
+
+    /// @brief run the case rounds times, false on the first run that differs
+    bool check(const Case &test, std::string &failure) {
+        for (int i = 0; i < rounds; i++) {
+            ScriptOutcome outcome = runScript(test.source);
+            bool reported = test.diagnostics.empty() ? outcome.diagnostics.empty()
+                                                     : outcome.diagnostics.find(test.diagnostics) != std::string::npos;
+            if (outcome.output != test.output || !reported || outcome.hadError != test.hadError ||
+                outcome.hadRuntimeError != test.hadRuntimeError) {
+                failure = std::string(test.name) + " run " + std::to_string(i) + ": output '" + outcome.output +
+                          "', diagnostics '" + outcome.diagnostics + "', hadError " +
+                          std::to_string(outcome.hadError) + ", hadRuntimeError " +
+                          std::to_string(outcome.hadRuntimeError);
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+int main() {
+    const std::vector<Case> cases = {
+            {"clean",
+             "var total = 0; for (var i = 0; i < 100; i = i + 1) { total = total + i; } print(\"clean\", total);",
+             "clean 4950 \n", "", false, false},
+            {"runtime error",
+             "print(\"before\"); var xs = [1, 2]; print(xs[5]); print(\"after\");",
+             "before \n", "Index out of range", false, true},
+            {"syntax error",
+             "print(\"never\"); var = 1;",
+             "", "Error", true, false},
+    };
+
+    std::vector<std::string> failures(cases.size());
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < cases.size(); i++) {
+        threads.emplace_back([&, i] { check(cases[i], failures[i]); });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+
+    int failed = 0;
+    for (const auto &failure: failures) {
+        if (!failure.empty()) {
+            std::cerr << "FAIL " << failure << '\n';
+            failed++;
+        }
+    }
+    if (failed == 0) {
+        std::cout << cases.size() << " cases passed on " << cases.size() << " threads\n";
+    }
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,55 @@
+// serialize and deserialize: values that must come back unchanged, shared
+// and cyclic containers, and byte strings that must be rejected cleanly.
+#include "RunScript.hpp"
+#include <string>
+#include <vector>
+
+namespace {
+    /// @brief a script that deserializes bytes, which go into a string literal as they are
+    std::string deserializing(const std::string &bytes) {
+        return "deserialize(\"LOX\x01" + bytes + "\");";
+    }
+}
+
+int main() {
+    const std::vector<ScriptCase> cases = {
+            {"scalars and lists",
+             "print(deserialize(serialize([1, \"two\", nil, true, false, [3.25, -7], 2147483647])));",
+             "[1,two,nil,true,false,[3.25,-7],2147483647] \n", ""},
+            {"instance",
+             "class Point { init(x, y) { this.x = x; this.y = y; } }"
+             "var q = deserialize(serialize(Point(1, 2.5))); print(q.x, q.y, q);",
+             "1 2.5 Point instance \n", ""},
+            {"map", "var m = map(); m.set(\"a\", 1); m.set(2, [3]);"
+                    "var n = deserialize(serialize(m)); print(n.get(\"a\"), n.get(2), n.len());",
+             "1 [3] 2 \n", ""},
+            {"shared list", "var a = [1]; var b = deserialize(serialize([a, a])); var first = b[0]; first.append(2);"
+                            "print(b);",
+             "[[1,2],[1,2]] \n", ""},
+            {"cycle", "var l = list(); l.append(1); l.append(l);"
+                      "var r = deserialize(serialize(l)); var inner = r[1]; inner.append(5); print(r.len());",
+             "3 \n", ""},
+            {"function", "serialize(clock);", "", "can not be serialized"},
+            {"not serialized", "deserialize(\"hello\");", "", "Data was not made by serialize"},
+            {"trailing bytes", "deserialize(serialize(1) + \"x\");", "", "Corrupt serialized data"},
+            {"empty", deserializing(""), "", "Corrupt serialized data"},
+            {"unknown tag", deserializing("\x7f"), "", "Corrupt serialized data"},
+            {"short list", deserializing("\x06\x05\x03\x02"), "", "Corrupt serialized data"},
+            {"short double", deserializing("\x04\x01\x02"), "", "Corrupt serialized data"},
+            {"short string", deserializing("\x05\x09" "abc"), "", "Corrupt serialized data"},
+            {"long varint", deserializing(std::string(11, '\xff')), "", "Corrupt serialized data"},
+            {"dangling reference", deserializing("\x06\x02\x0a\x05\x03"), "", "Corrupt serialized data"},
+            {"shared outside an isolate", deserializing("\x0b\x01"), "", "Corrupt serialized data"},
+            {"too deep", deserializing([] {
+                 std::string nested;
+                 for (int i = 0; i < 6000; i++) {
+                     nested += "\x06\x01";
+                 }
+                 return nested + "\x03";
+             }()),
+             "", "Corrupt serialized data"},
+            {"unknown class", deserializing("\x09\x05" "Ghost" "\x01"), "", "Unknown class 'Ghost'"},
+            {"not a class", deserializing("\x09\x05" "clock" "\x01"), "", "'clock' in serialized data is not a class"},
+    };
+    return runCases(cases);
+}
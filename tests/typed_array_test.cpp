@@ -0,0 +1,38 @@
+// Float64Array and Int64Array kernels at the edges: empty arrays, lengths
+// that leave a tail after the vector loop, and the Int64 element range.
+#include "RunScript.hpp"
+#include <vector>
+
+int main() {
+    const std::vector<ScriptCase> cases = {
+            {"empty",
+             "var e = Float64Array(0); print(e.len(), e.sum(), e.min(), e.max(), e.dot(Float64Array(0)));",
+             "0 0 nil nil 0 \n", ""},
+            {"odd tails",
+             "var lengths = [1, 3, 5, 7, 9, 15, 17, 33];"
+             "for (var k = 0; k < 8; k = k + 1) {"
+             "    var n = lengths[k];"
+             "    var a = Float64Array(n); a.fill(1.5); a[n - 1] = 4.0;"
+             "    var b = Float64Array(n); b.fill(2.0);"
+             "    a.add(b).scale(2.0);"
+             "    print(n, a.sum(), a.dot(b), a.min(), a.max());"
+             "}",
+             "1 12 24 12 12 \n3 26 52 7 12 \n5 40 80 7 12 \n7 54 108 7 12 \n9 68 136 7 12 \n"
+             "15 110 220 7 12 \n17 124 248 7 12 \n33 236 472 7 12 \n",
+             ""},
+            {"int64 kernels",
+             "var i = Int64Array(9); i.fill(3); i[8] = -5; print(i.sum(), i.min(), i.max(), i.dot(i));",
+             "19 -5 3 97 \n", ""},
+            {"int64 beyond int32", "var big = Int64Array([2147483647, 1]); print(big.sum(), big[-2]);",
+             "2147483648 2147483647 \n", ""},
+            {"from list()", "var l = list(); l.append(1.5); l.append(2.5); print(Float64Array(l).sum());", "4 \n",
+             ""},
+            {"int64 fraction", "var i = Int64Array(1); i[0] = 1.5;", "", "Int64Array elements must be integers"},
+            {"int64 out of range", "var i = Int64Array(1); i[0] = 9223372036854775808.0;", "",
+             "Int64Array elements must be integers"},
+            {"length mismatch", "Float64Array(2).dot(Float64Array(3));", "", "Array lengths differ: 2 and 3"},
+            {"index out of range", "var a = Float64Array(2); print(a[2]);", "", "Index out of range"},
+            {"length too large", "Float64Array(3000000000.0);", "", "length must be at most 2147483647"},
+    };
+    return runCases(cases);
+}
@@ -1,4 +1,8 @@
 #include "./include/vm.hpp"
+#include "./include/Logger.hpp"
+#include "./include/LoxJIT.hpp"
+#include "./include/LoxString.hpp"
+#include "./include/ModuleOptimizer.hpp"
 #include "Environment.hpp"
 #include "Expr.hpp"
 #include "Stmt.hpp"
@@ -8,23 +12,50 @@
 #include <llvm/IR/Function.h>
 #include <llvm/IR/GlobalVariable.h>
 #include <llvm/IR/Instructions.h>
+#include <llvm/IR/MDBuilder.h>
 #include <llvm/IR/Type.h>
 #include <llvm/IR/Value.h>
 #include <llvm/IR/Verifier.h>
 #include <llvm/Support/Casting.h>
 #include <llvm/Support/raw_ostream.h>
+#include <cstdint>
+#include <cstdlib>
 #include <memory>
 #include <regex>
 #include <string>
 
-llvm::Value *LoxVM::lastValue = nullptr;
+// runtime bitcode built next to the executable, LOX_RUNTIME overrides it;
+// without clang++ there is none and output.ll links against LOX_RUNTIME_LIB
+#ifndef LOX_RUNTIME_BC
+#define LOX_RUNTIME_BC ""
+#endif
+#ifndef LOX_RUNTIME_LIB
+#define LOX_RUNTIME_LIB "libloxruntime.a"
+#endif
+
 void LoxVM::exec(vector<shared_ptr<Stmt>> &statements) {
     // 1. compile ast
     compile(statements);
-    // 2. print llvm IR
+    // 2. optimize functions and classes concurrently
+    bool runtimeLinked = optimizeModule();
+    // 3. print llvm IR
     module->print(llvm::outs(), nullptr);
-    // 3. save module to file
+    // 4. save module to file
     saveModuleToFile("./output.ll");
+    if (!runtimeLinked) {
+        llvm::errs() << "[LoxVM]: output.ll calls the runtime, link it with " << LOX_RUNTIME_LIB << "\n";
+    }
+}
+
+int LoxVM::jit(vector<shared_ptr<Stmt>> &statements, const std::string &script) {
+    compile(statements);
+    optimizeModule();
+    LoxJIT jit(script);
+    return jit.run(std::move(module), std::move(ctx));
+}
+
+void LoxVM::setProfile(std::shared_ptr<const Profile> profile) {
+    this->profile = std::move(profile);
 }
 
 void LoxVM::saveModuleToFile(const std::string &fileName) {
@@ -33,6 +64,20 @@ void LoxVM::saveModuleToFile(const std::string &fileName) {
     module->print(outLL, nullptr);
 }
 
+/// @brief optimize the module, true when the runtime's definitions were
+/// linked into it
+bool LoxVM::optimizeModule() {
+    ModuleOptimizer optimizer(jobs, cacheDir);
+    auto runtime = std::getenv("LOX_RUNTIME");
+    std::string runtimePath = runtime != nullptr ? runtime : LOX_RUNTIME_BC;
+    bool linked = !runtimePath.empty() && optimizer.loadRuntime(runtimePath);
+    if (!runtimePath.empty() && !linked) {
+        llvm::errs() << "[LoxVM]: runtime " << runtimePath << " not found, runtime calls stay external\n";
+    }
+    module = optimizer.run(std::move(module), *ctx);
+    return linked;
+}
+
 void LoxVM::compile(vector<shared_ptr<Stmt>> &statements) {
     fn = createFunction("main", llvm::FunctionType::get(builder->getInt32Ty(), false), globalEnv);
 
@@ -47,7 +92,7 @@ llvm::Value *LoxVM::gen(vector<shared_ptr<Stmt>> &statements) {
     for (auto stmt: statements) {
         execute(stmt);
     }
-    return LoxVM::lastValue;
+    return lastValue;
 }
 
 void LoxVM::moduleInit() {
@@ -55,7 +100,7 @@ void LoxVM::moduleInit() {
     module = std::make_unique<llvm::Module>("lox", *ctx);
     builder = std::make_unique<llvm::IRBuilder<>>(*ctx);
     varsBuilder = std::make_unique<llvm::IRBuilder<>>(*ctx);
-    LoxVM::lastValue = builder->getInt32(0);
+    lastValue = builder->getInt32(0);
 }
 
 llvm::Function *LoxVM::createFunction(const std::string &fnName, llvm::FunctionType *fnType, Env env) {
@@ -78,7 +123,9 @@ llvm::Function *LoxVM::createFunctionProto(const std::string &fnName, llvm::Func
 }
 
 llvm::Value *LoxVM::allocVar(const std::string &name, llvm::Type *type, Env env) {
-    varsBuilder->SetInsertPoint(&fn->getEntryBlock());
+    // prepend, the entry block may already end in a branch
+    auto &entry = fn->getEntryBlock();
+    varsBuilder->SetInsertPoint(&entry, entry.getFirstInsertionPt());
     auto varAlloc = varsBuilder->CreateAlloca(type, 0, name.c_str());
 
     env->define(name, varAlloc);
@@ -107,8 +154,171 @@ void LoxVM::createFunctionBlock(llvm::Function *fn) {
 /* set up external functions like print*/
 void LoxVM::setupExternalFunctions() {
     // void print(string)
-    auto bytePtrTy = builder->getInt8PtrTy()->getPointerTo();
+    auto bytePtrTy = builder->getInt8PtrTy();
     module->getOrInsertFunction("printf", llvm::FunctionType::get(builder->getInt32Ty(), bytePtrTy, true));// true means varargs
+
+    // runtime library, see LoxRuntime.hpp; lists are opaque byte pointers here
+    auto voidTy = builder->getVoidTy();
+    auto i32Ty = builder->getInt32Ty();
+    auto i64Ty = builder->getInt64Ty();
+    auto f64Ty = builder->getDoubleTy();
+    auto declare = [&](const std::string &name, llvm::Type *result, std::vector<llvm::Type *> params) {
+        module->getOrInsertFunction(name, llvm::FunctionType::get(result, params, false));
+    };
+    declare("lox_panic", voidTy, {bytePtrTy});
+    module->getFunction("lox_panic")->addFnAttr(llvm::Attribute::NoReturn);
+    module->getFunction("lox_panic")->addFnAttr(llvm::Attribute::Cold);
+    declare("lox_str_concat", bytePtrTy, {bytePtrTy, bytePtrTy});
+    declare("lox_str_len", i32Ty, {bytePtrTy});
+    declare("lox_list_new", bytePtrTy, {i64Ty, i64Ty});
+    declare("lox_list_len", i64Ty, {bytePtrTy});
+    declare("lox_list_append_i32", voidTy, {bytePtrTy, i32Ty});
+    declare("lox_list_append_f64", voidTy, {bytePtrTy, f64Ty});
+    declare("lox_print_i32", voidTy, {i32Ty});
+    declare("lox_print_f64", voidTy, {f64Ty});
+    declare("lox_print_bool", voidTy, {i32Ty});
+    declare("lox_print_str", voidTy, {bytePtrTy});
+    declare("lox_print_newline", voidTy, {});
+}
+
+/* lists are loaded inline, only growing them calls the runtime */
+void LoxVM::setupListType() {
+    auto i64Ty = builder->getInt64Ty();
+    listTy = llvm::StructType::create(*ctx, {i64Ty, i64Ty, builder->getInt8PtrTy()}, "LoxRtList");
+
+    llvm::MDBuilder md(*ctx);
+    auto root = md.createTBAARoot("Lox TBAA");
+    auto lengthNode = md.createTBAAScalarTypeNode("lox.list.length", root);
+    auto dataNode = md.createTBAAScalarTypeNode("lox.list.data", root);
+    auto intNode = md.createTBAAScalarTypeNode("lox.int", root);
+    auto doubleNode = md.createTBAAScalarTypeNode("lox.double", root);
+    auto headerNode = md.createTBAAStructTypeNode("LoxRtList", {{lengthNode, 0}, {lengthNode, 8}, {dataNode, 16}});
+    tbaaLength = md.createTBAAStructTagNode(headerNode, lengthNode, 0);
+    tbaaData = md.createTBAAStructTagNode(headerNode, dataNode, 16);
+    tbaaInt = md.createTBAAStructTagNode(intNode, intNode, 0);
+    tbaaDouble = md.createTBAAStructTagNode(doubleNode, doubleNode, 0);
+}
+
+llvm::Value *LoxVM::listHeader(llvm::Value *handle, unsigned field, llvm::MDNode *tbaa, llvm::Type *type) {
+    auto header = builder->CreateBitCast(handle, listTy->getPointerTo());
+    auto load = builder->CreateLoad(type, builder->CreateStructGEP(listTy, header, field));
+    load->setMetadata(llvm::LLVMContext::MD_tbaa, tbaa);
+    return load;
+}
+
+llvm::MDNode *LoxVM::elementTbaa(llvm::Type *elemType) {
+    return elemType->isDoubleTy() ? tbaaDouble : tbaaInt;
+}
+
+llvm::Value *LoxVM::listElementPtr(llvm::Value *handle, llvm::Value *index, llvm::Type *elemType) {
+    // the length is 64 bits, compare in 64 bits so long lists keep their bound
+    auto length = listHeader(handle, 0, tbaaLength, builder->getInt64Ty());
+    auto data = listHeader(handle, 2, tbaaData, builder->getInt8PtrTy());
+    index = builder->CreateSExt(convert(index, builder->getInt32Ty()), builder->getInt64Ty());
+    // unsigned compare rejects negative indexes too; the failing side is cold
+    // so IRCE can split the check out of the loop's main range
+    auto inBounds = createBB("inbounds", fn);
+    auto outOfBounds = createBB("outofbounds", fn);
+    auto weights = llvm::MDBuilder(*ctx).createBranchWeights(1 << 20, 1);
+    builder->CreateCondBr(builder->CreateICmpULT(index, length), inBounds, outOfBounds, weights);
+
+    builder->SetInsertPoint(outOfBounds);
+    auto message = module->getNamedGlobal("lox.index.error");
+    callRuntime("lox_panic", {builder->CreateBitCast(message != nullptr ? message : builder->CreateGlobalString("Index out of range.", "lox.index.error"),
+                                                     builder->getInt8PtrTy())});
+    builder->CreateUnreachable();
+
+    builder->SetInsertPoint(inBounds);
+    auto elements = builder->CreateBitCast(data, elemType->getPointerTo());
+    return builder->CreateInBoundsGEP(elemType, elements, index);
+}
+
+Object LoxVM::callListMethod(llvm::Value *list, const Token &name, shared_ptr<Call<Object>> expr) {
+    auto elemType = listTypes[list];
+    if (name.lexeme == "len" && expr->arguments.empty()) {
+        // ints are 32 bits, a longer list reports the largest one instead of wrapping
+        auto length = listHeader(list, 0, tbaaLength, builder->getInt64Ty());
+        auto largest = builder->getInt64(INT32_MAX);
+        auto clamped = builder->CreateSelect(builder->CreateICmpULT(length, largest), length, largest);
+        return Object::make_llvmval_obj(builder->CreateTrunc(clamped, builder->getInt32Ty()));
+    } else if (name.lexeme == "append" && expr->arguments.size() == 1) {
+        auto value = convert(evaluate(expr->arguments[0]), elemType);
+        callRuntime("lox_list_append_" + listSuffix(elemType), {list, value});
+        return Object::make_llvmval_obj(builder->getInt32(0));
+    }
+    Error::ErrorLogMessage() << "[LoxVM]: list has no method " << name.lexeme;
+    return Object::make_llvmval_obj(builder->getInt32(0));
+}
+
+llvm::Value *LoxVM::callRuntime(const std::string &name, std::vector<llvm::Value *> args) {
+    return builder->CreateCall(module->getFunction(name), args);
+}
+
+std::string LoxVM::listSuffix(llvm::Type *elemType) {
+    if (elemType->isDoubleTy()) {
+        return "f64";
+    } else if (elemType->isIntegerTy(32)) {
+        return "i32";
+    }
+    Error::ErrorLogMessage() << "[LoxVM]: list elements must be int or double";
+    return "";
+}
+
+llvm::Value *LoxVM::convert(llvm::Value *value, llvm::Type *type) {
+    auto from = value->getType();
+    if (from == type) {
+        return value;
+    } else if (from->isIntegerTy() && type->isDoubleTy()) {
+        return builder->CreateSIToFP(value, type);
+    } else if (from->isDoubleTy() && type->isIntegerTy()) {
+        return builder->CreateFPToSI(value, type);
+    } else if (from->isIntegerTy() && type->isIntegerTy()) {
+        return builder->CreateSExtOrTrunc(value, type);
+    }
+    return value;
+}
+
+/// @brief llvm type of a type() name seen by the profile, null if unsupported
+llvm::Type *LoxVM::profiledType(const std::string &typeName) {
+    if (typeName == "int") {
+        return builder->getInt32Ty();
+    } else if (typeName == "float") {
+        return builder->getDoubleTy();
+    } else if (typeName == "bool") {
+        return builder->getInt1Ty();
+    } else if (typeName == "str") {
+        return builder->getInt8PtrTy();
+    }
+    return nullptr;
+}
+
+llvm::MDNode *LoxVM::branchWeights(int node) {
+    auto branch = profile != nullptr ? profile->findBranch(node) : nullptr;
+    if (branch == nullptr) {
+        return nullptr;
+    }
+    // branch weights are 32 bit
+    uint64_t taken = branch->taken, notTaken = branch->notTaken;
+    while (taken > UINT32_MAX || notTaken > UINT32_MAX) {
+        taken /= 2;
+        notTaken /= 2;
+    }
+    return llvm::MDBuilder(*ctx).createBranchWeights(taken, notTaken);
+}
+
+void LoxVM::printValue(llvm::Value *value) {
+    auto type = value->getType();
+    if (type->isDoubleTy()) {
+        callRuntime("lox_print_f64", {value});
+    } else if (type->isIntegerTy(1)) {
+        callRuntime("lox_print_bool", {builder->CreateZExt(value, builder->getInt32Ty())});
+    } else if (type->isIntegerTy()) {
+        callRuntime("lox_print_i32", {builder->CreateSExtOrTrunc(value, builder->getInt32Ty())});
+    } else if (type->isPointerTy() && listTypes.count(value) == 0) {
+        callRuntime("lox_print_str", {value});
+    } else {
+        Error::ErrorLogMessage() << "[LoxVM]: value can not be printed";
+    }
 }
 
 void LoxVM::setupGlobalEnvironment() {
@@ -133,7 +343,7 @@ llvm::Type *LoxVM::excrateVarType(std::shared_ptr<Expr<Object>> expr) {
         switch (literal->value.data.index()) {
             case 0:
                 // string type
-                return builder->getInt8PtrTy()->getPointerTo();
+                return builder->getInt8PtrTy();
             case 1:
                 // double type
                 return builder->getDoubleTy();
@@ -152,8 +362,12 @@ llvm::Type *LoxVM::excrateVarType(const string &typeName) {
 
     if (typeName == "int") {
         return builder->getInt32Ty();
-    } else if (typeName == "str") {
-        return builder->getInt8PtrTy()->getPointerTo();
+    } else if (typeName == "float") {
+        return builder->getDoubleTy();
+    } else if (typeName == "bool") {
+        return builder->getInt1Ty();
+    } else if (typeName == "str" || typeName == "list") {
+        return builder->getInt8PtrTy();
     } else if (typeName == "") {
         return builder->getInt32Ty();
     }
@@ -247,10 +461,23 @@ llvm::FunctionType *LoxVM::excrateFunType(shared_ptr<Function> stmt) {
     auto params = stmt->params;
     auto returnType = stmt->returnTypeName.type == NIL ? builder->getInt32Ty()
                                                        : excrateVarType(stmt->returnTypeName.lexeme);
+    // unannotated types are specialized for the types the profile observed
+    auto entry = profile != nullptr ? profile->findFunction(stmt->nodeId) : nullptr;
+    if (entry != nullptr && stmt->returnTypeName.type == NIL && profiledType(entry->returnType) != nullptr) {
+        returnType = profiledType(entry->returnType);
+    }
     // auto returnType = builder->getInt32Ty();
     std::vector<llvm::Type *> paramTypes{};
+    size_t profiled = 0;// 'this' is not an argument in the profile
     for (auto &param: params) {
         auto paramType = excrateVarType(param.second);
+        if (param.first.lexeme != "this" && entry != nullptr && param.second.empty() && profiled < entry->paramTypes.size()) {
+            auto observed = profiledType(entry->paramTypes[profiled]);
+            paramType = observed != nullptr ? observed : paramType;
+        }
+        if (param.first.lexeme != "this") {
+            profiled++;
+        }
         // auto paramType = builder->getInt32Ty();
         auto paramName = param.first.lexeme;
         paramTypes.push_back(paramName == "this" ? (llvm::Type *) cls->getPointerTo() : paramType);
@@ -282,7 +509,7 @@ Object LoxVM::visitLiteralExpr(shared_ptr<Literal<Object>> expr) {
     switch (expr->value.data.index()) {
         case 0: {
             // string type
-            std::string str_data = std::get<std::string>(expr->value.data);
+            std::string str_data = std::get<shared_ptr<LoxString>>(expr->value.data)->str();
             // handle the \n
             auto re = std::regex("\\\\n");
             str_data = std::regex_replace(str_data, re, "\n");
@@ -326,27 +553,61 @@ Object LoxVM::visitAssignExpr(shared_ptr<Assign<Object>> expr) {
 
 Object LoxVM::visitBinaryExpr(shared_ptr<Binary<Object>> expr) {
     //llvm to generate IR for binary
-    if (expr->operation.lexeme == "+") {
+    auto left = evaluate(expr->left);
+    auto right = evaluate(expr->right);
+    auto op = expr->operation.lexeme;
+    // string concatenation
+    if (op == "+" && left->getType()->isPointerTy() && right->getType()->isPointerTy()) {
+        return Object::make_llvmval_obj(callRuntime("lox_str_concat", {left, right}));
+    }
+    // floating point, an int operand is converted
+    if (left->getType()->isDoubleTy() || right->getType()->isDoubleTy()) {
+        left = convert(left, builder->getDoubleTy());
+        right = convert(right, builder->getDoubleTy());
+        if (op == "+") {
+            GEN_BINARY_OP(CreateFAdd, "tmpadd");
+        } else if (op == "-") {
+            GEN_BINARY_OP(CreateFSub, "tmpsub");
+        } else if (op == "*") {
+            GEN_BINARY_OP(CreateFMul, "tmpmul");
+        } else if (op == "/") {
+            GEN_BINARY_OP(CreateFDiv, "tmpdiv");
+        } else if (op == ">") {
+            GEN_BINARY_OP(CreateFCmpOGT, "tmpcmp");
+        } else if (op == "<") {
+            GEN_BINARY_OP(CreateFCmpOLT, "tmpcmp");
+        } else if (op == "==") {
+            GEN_BINARY_OP(CreateFCmpOEQ, "tmpcmp");
+        } else if (op == "!=") {
+            GEN_BINARY_OP(CreateFCmpUNE, "tmpcmp");
+        } else if (op == ">=") {
+            GEN_BINARY_OP(CreateFCmpOGE, "tmpcmp");
+        } else if (op == "<=") {
+            GEN_BINARY_OP(CreateFCmpOLE, "tmpcmp");
+        }
+        return Object::make_llvmval_obj(builder->getInt32(0));
+    }
+    if (op == "+") {
         GEN_BINARY_OP(CreateAdd, "tmpadd");
-    } else if (expr->operation.lexeme == "-") {
+    } else if (op == "-") {
         GEN_BINARY_OP(CreateSub, "tmpsub");
-    } else if (expr->operation.lexeme == "*") {
+    } else if (op == "*") {
         GEN_BINARY_OP(CreateMul, "tmpmul");
-    } else if (expr->operation.lexeme == "/") {
+    } else if (op == "/") {
         GEN_BINARY_OP(CreateSDiv, "tmpdiv");
     }
     // Unsigned comparison
-    else if (expr->operation.lexeme == ">") {
+    else if (op == ">") {
         GEN_BINARY_OP(CreateICmpUGT, "tmpcmp");
-    } else if (expr->operation.lexeme == "<") {
+    } else if (op == "<") {
         GEN_BINARY_OP(CreateICmpULT, "tmpcmp");
-    } else if (expr->operation.lexeme == "==") {
+    } else if (op == "==") {
         GEN_BINARY_OP(CreateICmpEQ, "tmpcmp");
-    } else if (expr->operation.lexeme == "!=") {
+    } else if (op == "!=") {
         GEN_BINARY_OP(CreateICmpNE, "tmpcmp");
-    } else if (expr->operation.lexeme == ">=") {
+    } else if (op == ">=") {
         GEN_BINARY_OP(CreateICmpUGE, "tmpcmp");
-    } else if (expr->operation.lexeme == "<=") {
+    } else if (op == "<=") {
         GEN_BINARY_OP(CreateICmpULE, "tmpcmp");
     }
     return Object::make_llvmval_obj(builder->getInt32(0));
@@ -367,6 +628,9 @@ Object LoxVM::visitVariableExpr(shared_ptr<Variable<Object>> expr) {
     //local variable
     if (auto localVar = llvm::dyn_cast<llvm::AllocaInst>(value)) {
         auto var = builder->CreateLoad(localVar->getAllocatedType(), localVar, varName.c_str());
+        if (listTypes.count(localVar) != 0) {
+            listTypes[var] = listTypes[localVar];
+        }
         return Object::make_llvmval_obj(var);
     }
 
@@ -393,14 +657,65 @@ Object LoxVM::visitDecrementExpr(shared_ptr<Decrement<Object>> expr) {
 }
 
 Object LoxVM::visitListExpr(shared_ptr<List<Object>> expr) {
-    return Object::make_llvmval_obj(builder->getInt32(0));
+    // the first item decides the element type, empty lists hold ints
+    std::vector<llvm::Value *> items;
+    for (auto item: expr->items) {
+        items.push_back(evaluate(item));
+    }
+    auto elemType = items.empty() ? builder->getInt32Ty() : items[0]->getType();
+    auto suffix = listSuffix(elemType);
+    auto elemSize = module->getDataLayout().getTypeAllocSize(elemType);
+    auto list = llvm::cast<llvm::CallInst>(callRuntime("lox_list_new", {builder->getInt64(elemSize), builder->getInt64(items.size())}));
+    // a fresh header that is never freed, so header loads may be hoisted out
+    // of loops; LLVM only trusts these on the call itself, not the declaration
+    list->addRetAttr(llvm::Attribute::NoAlias);
+    list->addRetAttr(llvm::Attribute::NonNull);
+    list->addRetAttr(llvm::Attribute::getWithDereferenceableBytes(*ctx, sizeof(int64_t) * 2 + sizeof(void *)));
+    list->addRetAttr(llvm::Attribute::getWithAlignment(*ctx, llvm::Align(alignof(int64_t))));
+    for (auto item: items) {
+        if (item->getType() != elemType) {
+            Error::ErrorLogMessage() << "[LoxVM]: list items must have the same type";
+        }
+        callRuntime("lox_list_append_" + suffix, {list, item});
+    }
+    listTypes[list] = elemType;
+    return Object::make_llvmval_obj(list);
 }
 
 Object LoxVM::visitSubscriptExpr(shared_ptr<Subscript<Object>> expr) {
-    return Object::make_llvmval_obj(builder->getInt32(0));
+    auto list = environment->lookup(expr->identifier.lexeme);
+    if (listTypes.count(list) == 0) {
+        Error::ErrorLogMessage() << "[LoxVM]: " << expr->identifier.lexeme << " can not be subscripted";
+    }
+    if (expr->slice) {
+        Error::ErrorLogMessage() << "[LoxVM]: slices are not supported";
+    }
+    auto elemType = listTypes[list];
+    auto handle = builder->CreateLoad(builder->getInt8PtrTy(), list, expr->identifier.lexeme.c_str());
+    auto index = evaluate(expr->index);
+    // a[i] = value
+    if (expr->value != nullptr) {
+        auto value = convert(evaluate(expr->value), elemType);
+        auto store = builder->CreateStore(value, listElementPtr(handle, index, elemType));
+        store->setMetadata(llvm::LLVMContext::MD_tbaa, elementTbaa(elemType));
+        return Object::make_llvmval_obj(value);
+    }
+    auto load = builder->CreateLoad(elemType, listElementPtr(handle, index, elemType));
+    load->setMetadata(llvm::LLVMContext::MD_tbaa, elementTbaa(elemType));
+    return Object::make_llvmval_obj(load);
 }
 
 Object LoxVM::visitCallExpr(shared_ptr<Call<Object>> expr) {
+    // methods of list variables
+    if (expr->callee->type == ExprType::Get) {
+        auto get = std::dynamic_pointer_cast<Get<Object>>(expr->callee);
+        if (get->object->type == ExprType::Variable) {
+            auto object = evaluate(get->object);
+            if (listTypes.count(object) != 0) {
+                return callListMethod(object, get->name, expr);
+            }
+        }
+    }
     auto callable = evaluate(expr->callee);
     std::vector<llvm::Value *> args{};
     for (auto arg: expr->arguments) {
@@ -408,7 +723,14 @@ Object LoxVM::visitCallExpr(shared_ptr<Call<Object>> expr) {
     }
 
     auto fn = (llvm::Function *) callable;
+    for (size_t i = 0; i < args.size() && i < fn->arg_size(); i++) {
+        args[i] = convert(args[i], fn->getArg(i)->getType());
+    }
     auto val = builder->CreateCall(fn, args);
+    // a call the profiled run never reached
+    if (profile != nullptr && profile->findCall(expr->nodeId) == nullptr) {
+        val->addFnAttr(llvm::Attribute::Cold);
+    }
     return Object::make_llvmval_obj(val);
 }
 
@@ -428,6 +750,11 @@ Object LoxVM::visitSuperExpr(shared_ptr<Super<Object>> expr) {
     return Object::make_llvmval_obj(builder->getInt32(0));
 }
 
+Object LoxVM::visitYieldExpr(shared_ptr<Yield<Object>> expr) {
+    Error::ErrorLogMessage() << "[LoxVM]: generators are not supported";
+    return Object::make_nil_obj();
+}
+
 void LoxVM::visitExpressionStmt(const Expression &stmt) {
     lastValue = evaluate(stmt.expression);
     Values.push_back(lastValue);
@@ -442,8 +769,19 @@ void LoxVM::visitPrintStmt(const Print &stmt) {
         args.push_back(evaluate(arg));
     }
 
-    lastValue = builder->CreateCall(printFn, args);
-    Values.push_back(lastValue);
+    // a leading string literal is a printf format
+    if (!expr->arguments.empty() && expr->arguments[0]->type == ExprType::Literal && args[0]->getType()->isPointerTy()) {
+        lastValue = builder->CreateCall(printFn, args);
+        Values.push_back(lastValue);
+        return;
+    }
+    // otherwise print the values like the interpreter does
+    for (auto arg: args) {
+        printValue(arg);
+    }
+    Values.push_back(callRuntime("lox_print_newline", {}));
+    // the value of a statement must not be void, if statements merge it in a phi
+    lastValue = builder->getInt32(0);
 }
 
 void LoxVM::visitVarStmt(const Var &stmt) {
@@ -467,8 +805,12 @@ void LoxVM::visitVarStmt(const Var &stmt) {
             return;
         }
         auto init = evaluate(stmt.initializer);
-        auto varTy = excrateVarType(stmt.typeName);
+        // untyped variables take the type of their initializer
+        auto varTy = stmt.typeName.empty() ? init->getType() : excrateVarType(stmt.typeName);
         auto varBinding = allocVar(varName, varTy, environment);
+        if (listTypes.count(init) != 0) {
+            listTypes[varBinding] = listTypes[init];
+        }
         lastValue = builder->CreateStore(init, varBinding);
         Values.push_back(lastValue);
         return;
@@ -535,43 +877,27 @@ void LoxVM::visitIfStmt(const If &stmt) {
     auto ifEndBlock = createBB("ifend");
 
     // conditon branch
-    builder->CreateCondBr(conditon, thenBlock, elseBlock);
+    builder->CreateCondBr(conditon, thenBlock, elseBlock, branchWeights(stmt.nodeId));
     // then branch
     builder->SetInsertPoint(thenBlock);
     execute(stmt.main_branch.statement);
-    auto thenRes = lastValue;
     builder->CreateBr(ifEndBlock);
-    // restore block to handle nested if expression
-    // which is needed for phi instruction
-    thenBlock = builder->GetInsertBlock();
     // else branch
     // append block to function
     elseBlock->insertInto(fn);// in llvm 17
     // fn->getBasicBlockList().push_back(elseBlock); in llvm 14
     builder->SetInsertPoint(elseBlock);
-    llvm::Value *elseRes = lastValue;
     if (stmt.else_branch != nullptr) {
         execute(stmt.else_branch);
-        elseRes = lastValue;
-    } else {
-        // If there's no else block, create a branch from elseBlock to ifEndBlock directly
-        // and set the default elseRes value.
-        elseRes = builder->getInt32(0);// Set default value for elseRes
     }
-
     builder->CreateBr(ifEndBlock);
-    // same for else block
-    elseBlock = builder->GetInsertBlock();
     // endif
     ifEndBlock->insertInto(fn);
     // fn->getBasicBlockList().push_back(ifEndBlock);
     builder->SetInsertPoint(ifEndBlock);
-
-    // result of if expression is phi
-    auto phi = builder->CreatePHI(thenRes->getType(), 2, "tmpif");
-    phi->addIncoming(thenRes, thenBlock);
-    phi->addIncoming(elseRes, elseBlock);
-    lastValue = phi;
+    // an if statement has no value; a phi of the branches' last values
+    // would mix types once a branch ends in double arithmetic
+    lastValue = builder->getInt32(0);
 }
 void LoxVM::visitWhileStmt(const While &stmt) {
     // condition
@@ -587,7 +913,7 @@ void LoxVM::visitWhileStmt(const While &stmt) {
     auto condition = evaluate(stmt.condition);
 
     // condition branch
-    builder->CreateCondBr(condition, bodyBlock, loopEndBlock);
+    builder->CreateCondBr(condition, bodyBlock, loopEndBlock, branchWeights(stmt.nodeId));
 
     // body
     bodyBlock->insertInto(fn);
@@ -614,6 +940,16 @@ void LoxVM::visitFunctionStmt(shared_ptr<Function> stmt) {
     auto prevEnv = environment;
     // override fn to compile body
     auto newFn = createFunction(fnName, excrateFunType(stmt), environment);
+    newFn->addFnAttr(LoxJIT::lineAttribute, std::to_string(stmt->functionName.line));
+    if (profile != nullptr) {
+        auto entry = profile->findFunction(stmt->nodeId);
+        newFn->setEntryCount(entry != nullptr ? entry->count : 0);
+        if (entry == nullptr) {
+            newFn->addFnAttr(llvm::Attribute::Cold);
+        } else if (entry->count >= hotFunctionCalls) {
+            newFn->addFnAttr(llvm::Attribute::InlineHint);
+        }
+    }
     fn = newFn;
 
     // set parameter name
@@ -642,7 +978,7 @@ void LoxVM::visitFunctionStmt(shared_ptr<Function> stmt) {
 
 void LoxVM::visitReturnStmt(const Return &stmt) {
     auto returnVal = evaluate(stmt.value);
-    builder->CreateRet(returnVal);
+    builder->CreateRet(convert(returnVal, fn->getReturnType()));
 }
 
 void LoxVM::visitBreakStmt(const Break &stmt) {}